@@ -1,4 +1,7 @@
 #include <chan/chan/chan.h>
+#include <chan/chan/conflatingchan.h>
+#include <chan/chan/mpmcchan.h>
+#include <chan/chan/spscchan.h>
 #include <chan/debug/trace.h>
 #include <chan/errors/error.h>
 #include <chan/fileevents/readintobuffer.h>
@@ -8,17 +11,24 @@
 #include <chan/select/lasterror.h>
 #include <chan/select/random.h>
 #include <chan/select/select.h>
+#include <chan/select/selectbackend.h>
+#include <chan/select/selectset.h>
+#include <chan/threading/mutex.h>
 #include <chan/time/duration.h>
 #include <chan/time/timepoint.h>
 #include <chan/timeevents/deadline.h>
+#include <chan/timeevents/otherwise.h>
 #include <chan/timeevents/timeout.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <map>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -26,6 +36,36 @@
 #include <pthread.h>
 #include <unistd.h>  // sleep
 
+// Count calls to the global `operator new`, so that `testSelectAllocations`
+// can check that `select` doesn't allocate.
+namespace {
+long numAllocations = 0;
+}  // namespace
+
+#if __cplusplus >= 201103
+#define SCRATCH_THROWS_BAD_ALLOC
+#else
+#define SCRATCH_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void* operator new(std::size_t size) SCRATCH_THROWS_BAD_ALLOC {
+    ++numAllocations;
+    if (void* const result = std::malloc(size ? size : 1)) {
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) CHAN_NOEXCEPT {
+    std::free(block);
+}
+
+#if __cplusplus >= 201402
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+#endif
+
 namespace {
 
 int testFile(int argc, char* argv[]) {
@@ -430,6 +470,1310 @@ int testRandom(int, char* argv[]) {
     return 0;
 }
 
+int testSelectAllocations(int, char*[]) {
+    int files[2];
+    int rc = pipe(files);
+    assert(rc == 0);
+
+    const char message[] = "x";
+    char       buffer[sizeof message];
+
+    using chan::read;
+    using chan::select;
+    using chan::timeout;
+    using chan::write;
+
+    // Warm up, so that any one-time allocations are out of the way.
+    rc = select(write(files[1], message, 1), timeout(chan::seconds(1)));
+    assert(rc == 0);
+    rc = select(read(files[0], buffer, 1), timeout(chan::seconds(1)));
+    assert(rc == 0);
+
+    const int  numIterations = 1000;
+    const long before        = numAllocations;
+    for (int i = 0; i < numIterations; ++i) {
+        rc = select(write(files[1], message, 1), timeout(chan::seconds(1)));
+        assert(rc == 0);
+        rc = select(read(files[0], buffer, 1), timeout(chan::seconds(1)));
+        assert(rc == 0);
+    }
+    const long allocations = numAllocations - before;
+
+    std::cout << allocations << " allocations in " << 2 * numIterations
+              << " calls to select\n";
+
+    ::close(files[0]);
+    ::close(files[1]);
+
+    return allocations != 0;
+}
+
+int testShuffleCost(int argc, char* argv[]) {
+    const int numIterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    assert(numIterations > 0);
+
+    int numbers[] = {0, 1};
+
+    // What `select` used to do: seed a new generator from the system's
+    // entropy source for every shuffle.
+    chan::TimePoint before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::Random15 generator(chan::systemRandom());
+        chan::shuffle(numbers, numbers + 2, generator);
+    }
+    std::cout << "shuffle seeded by systemRandom: "
+              << (chan::now() - before) / numIterations << "\n";
+
+    // What `select` does now: use the thread's pseudo-random sequence.
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::shuffle(numbers, numbers + 2);
+    }
+    std::cout << "shuffle using ThreadRandom15:   "
+              << (chan::now() - before) / numIterations << "\n";
+
+    // A whole `select` whose events are both immediately ready.
+    using chan::timeout;
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::select(timeout(chan::seconds(0)), timeout(chan::seconds(0)));
+    }
+    std::cout << "select of two expired timeouts: "
+              << (chan::now() - before) / numIterations << "\n";
+
+    return 0;
+}
+
+// Use the `chan::SelectBackend` having the specified `name`, which is one of
+// "poll", "epoll", or "uring".  Other names are ignored.
+void setSelectBackend(const std::string& name) {
+    if (name == "poll") {
+        chan::setSelectBackend(chan::SelectBackend::POLL);
+    }
+    else if (name == "epoll") {
+        chan::setSelectBackend(chan::SelectBackend::EPOLL);
+    }
+    else if (name == "uring") {
+        chan::setSelectBackend(chan::SelectBackend::IO_URING);
+    }
+}
+
+struct SelectRangeOnce {
+    std::vector<chan::EventRef>* events;
+
+    int operator()() {
+        return chan::selectRange(*events);
+    }
+};
+
+struct SelectSetSelect {
+    chan::SelectSet* selectSet;
+
+    int operator()() {
+        return selectSet->select();
+    }
+};
+
+// Repeatedly make one of the pipes having the specified `writeEnds` readable,
+// and then invoke the specified `doSelect`, checking that it selected the
+// read from that pipe.  Print the average time taken per selection.  Return
+// zero on success or a nonzero value if a selection went wrong.
+template <typename SELECT>
+int timeSelections(SELECT&                 doSelect,
+                   const std::vector<int>& writeEnds,
+                   int                     numIterations) {
+    const int             numFiles = writeEnds.size();
+    const chan::TimePoint before   = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        const int which = (i * 7919) % numFiles;
+        const int rc    = ::write(writeEnds[which], "x", 1);
+        assert(rc == 1);
+        (void)rc;
+
+        const int result = doSelect();
+        if (result != which) {
+            std::cerr << "expected " << which << " but got " << result << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << (chan::now() - before) / numIterations;
+    return 0;
+}
+
+int testSelectRange(int argc, char* argv[]) {
+    const int numFiles      = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int numIterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+    assert(numFiles > 0);
+    assert(numIterations > 0);
+
+    if (argc > 3) {
+        setSelectBackend(argv[3]);
+    }
+
+    // One pipe per event, plus a timeout, so that the events are of mixed
+    // kinds.  The `ReadIntoBufferEvent`s must not move once they're referred
+    // to by `EventRef`s, hence `reserve`.
+    std::vector<int>                       readEnds;
+    std::vector<int>                       writeEnds;
+    std::vector<chan::ReadIntoBufferEvent> reads;
+    std::vector<chan::EventRef>            events;
+    char                                   buffer[1];
+
+    readEnds.reserve(numFiles);
+    writeEnds.reserve(numFiles);
+    reads.reserve(numFiles);
+    events.reserve(numFiles + 1);
+
+    for (int i = 0; i < numFiles; ++i) {
+        int       files[2];
+        const int rc = pipe(files);
+        assert(rc == 0);
+        (void)rc;
+        readEnds.push_back(files[0]);
+        writeEnds.push_back(files[1]);
+        reads.push_back(chan::read(files[0], buffer));
+        events.push_back(chan::EventRef(reads.back()));
+    }
+
+    chan::TimeoutEvent timeoutEvent = chan::timeout(chan::seconds(10));
+    events.push_back(chan::EventRef(timeoutEvent));
+
+    SelectRangeOnce once = {&events};
+    if (timeSelections(once, writeEnds, numIterations)) {
+        return 1;
+    }
+    std::cout << " per selectRange of " << events.size() << " events\n";
+
+    chan::SelectSet selectSet;
+    for (int i = 0; i < numFiles; ++i) {
+        selectSet.add(reads[i]);
+    }
+    selectSet.add(timeoutEvent);
+
+    SelectSetSelect repeatedly = {&selectSet};
+    if (timeSelections(repeatedly, writeEnds, numIterations)) {
+        return 1;
+    }
+    std::cout << " per SelectSet::select of " << selectSet.size()
+              << " events\n";
+
+    for (int i = 0; i < numFiles; ++i) {
+        ::close(readEnds[i]);
+        ::close(writeEnds[i]);
+    }
+
+    return 0;
+}
+
+int testManyDeadlines(int argc, char* argv[]) {
+    const int numDeadlines = argc > 1 ? std::atoi(argv[1]) : 1000;
+    assert(numDeadlines > 0);
+
+    // Deadlines 100 microseconds apart, added to the `SelectSet` in a
+    // shuffled order.  They must expire in chronological order.
+    std::vector<int> order;
+    for (int i = 0; i < numDeadlines; ++i) {
+        order.push_back(i);
+    }
+    chan::Random15 generator(0);  // seeded with zero
+    chan::shuffle(order, generator);
+
+    const chan::TimePoint start = chan::now() + chan::milliseconds(10);
+    const chan::Duration  step  = chan::nanoseconds(100 * 1000);
+    const chan::TimePoint never = start + chan::seconds(3600);
+
+    chan::SelectSet selectSet;
+    for (int i = 0; i < numDeadlines; ++i) {
+        selectSet.add(chan::deadline(start + order[i] * step));
+    }
+
+    for (int expected = 0; expected < numDeadlines; ++expected) {
+        const int index = selectSet.select();
+        if (index < 0 || order[index] != expected) {
+            std::cerr << "expected deadline " << expected << " but got index "
+                      << index << "\n";
+            return 1;
+        }
+
+        // Replace the expired deadline with one that won't expire.
+        selectSet.set(index, chan::deadline(never));
+    }
+
+    std::cout << numDeadlines << " deadlines expired in order, in "
+              << (chan::now() - start) << " (ideally "
+              << (numDeadlines - 1) * step << ")\n";
+
+    return 0;
+}
+
+int testTimeoutPrecision(int argc, char* argv[]) {
+    const long microseconds  = argc > 1 ? std::atol(argv[1]) : 300;
+    const int  numIterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+    assert(microseconds >= 0);
+    assert(numIterations > 0);
+
+    if (argc > 3) {
+        setSelectBackend(argv[3]);
+    }
+
+    const chan::Duration requested = chan::nanoseconds(microseconds * 1000);
+
+    // Besides lateness, measure the processor time used, which reveals a
+    // `select` that spins rather than sleeping until the deadline.
+    const std::clock_t cpuBefore = std::clock();
+
+    chan::Duration totalLateness;
+    chan::Duration worstLateness;
+    for (int i = 0; i < numIterations; ++i) {
+        const chan::TimePoint before = chan::now();
+        const int rc = chan::select(chan::timeout(requested));
+        assert(rc == 0);
+        (void)rc;
+
+        const chan::Duration lateness = (chan::now() - before) - requested;
+        if (lateness < chan::Duration()) {
+            std::cerr << "timeout fired early by "
+                      << (chan::Duration() - lateness) << "\n";
+            return 1;
+        }
+
+        totalLateness += lateness;
+        if (lateness > worstLateness) {
+            worstLateness = lateness;
+        }
+    }
+
+    std::cout << "timeout of " << requested << " fired late by "
+              << totalLateness / numIterations << " on average, and by "
+              << worstLateness << " at worst, using "
+              << (std::clock() - cpuBefore) * 1000000.0 / CLOCKS_PER_SEC /
+                     numIterations
+              << " microseconds of processor time each\n";
+
+    return 0;
+}
+
+void* sendFortyTwo(void* chanRaw) {
+    chan::Chan<int>& numbers = *static_cast<chan::Chan<int>*>(chanRaw);
+    numbers.send(42);
+    return 0;
+}
+
+int testOtherwise(int argc, char* argv[]) {
+    const int numIterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    assert(numIterations > 0);
+
+    using chan::deadline;
+    using chan::otherwise;
+    using chan::select;
+
+    chan::Chan<int> numbers;
+    chan::Chan<>    done;
+    int             number = 0;
+
+    // Nobody is sending, so `otherwise` is selected every time.
+    chan::TimePoint before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        if (select(numbers.recv(&number), done.recv(), otherwise()) != 2) {
+            std::cerr << "expected otherwise() to be selected\n";
+            return 1;
+        }
+    }
+    std::cout << "miss using otherwise():      "
+              << (chan::now() - before) / numIterations << "\n";
+
+    // The same, using an expired deadline instead.
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        if (select(numbers.recv(&number),
+                   done.recv(),
+                   deadline(chan::now())) != 2) {
+            std::cerr << "expected the deadline to be selected\n";
+            return 1;
+        }
+    }
+    std::cout << "miss using deadline(now()): "
+              << (chan::now() - before) / numIterations << "\n";
+
+    // A readable file is preferred to `otherwise`.
+    int files[2];
+    int rc = pipe(files);
+    assert(rc == 0);
+    rc = ::write(files[1], "x", 1);
+    assert(rc == 1);
+    char buffer[1];
+    rc = select(
+        numbers.recv(&number), chan::read(files[0], buffer), otherwise());
+    if (rc != 1) {
+        std::cerr << "expected the read to be selected\n";
+        return 1;
+    }
+    ::close(files[0]);
+    ::close(files[1]);
+
+    // So is an expired deadline.
+    if (select(otherwise(), deadline(chan::now())) != 1) {
+        std::cerr << "expected the deadline to be selected\n";
+        return 1;
+    }
+
+    // A sender in another thread is eventually received from.
+    pthread_t sender;
+    rc = pthread_create(&sender, 0, sendFortyTwo, &numbers);
+    assert(rc == 0);
+    int numMisses = 0;
+    while (select(numbers.recv(&number), otherwise()) == 1) {
+        ++numMisses;
+    }
+    rc = pthread_join(sender, 0);
+    assert(rc == 0);
+    std::cout << "received " << number << " after " << numMisses
+              << " misses\n";
+
+    return number != 42;
+}
+
+// Receive one value from any of the `chan::Chan<int>` objects in the
+// specified `std::vector`.
+void* recvFromAny(void* chansRaw) {
+    std::vector<chan::Chan<int> >& chans =
+        *static_cast<std::vector<chan::Chan<int> >*>(chansRaw);
+
+    int                                 value;
+    std::vector<chan::RecvEvent<int> >  recvs;
+    std::vector<chan::EventRef>         events;
+    recvs.reserve(chans.size());
+    for (std::size_t i = 0; i < chans.size(); ++i) {
+        recvs.push_back(chans[i].recv(&value));
+        events.push_back(chan::EventRef(recvs.back()));
+    }
+
+    const int rc = chan::selectRange(events);
+    assert(rc >= 0);
+    (void)rc;
+    return 0;
+}
+
+// Echo values from the first of the specified pair of `chan::Chan<int>` back
+// on the second, until receiving a negative value.
+void* echo(void* chansRaw) {
+    chan::Chan<int>* const chans = static_cast<chan::Chan<int>*>(chansRaw);
+    for (;;) {
+        const int value = chans[0].recv();
+        chans[1].send(value);
+        if (value < 0) {
+            return 0;
+        }
+    }
+}
+
+// Return the number of open file descriptors in this process.
+int countOpenFiles() {
+    const long maxFiles = std::min(sysconf(_SC_OPEN_MAX), 65536L);
+    int        count    = 0;
+    for (int fd = 0; fd < maxFiles; ++fd) {
+        if (::fcntl(fd, F_GETFD) != -1) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int testWakeupFiles(int argc, char* argv[]) {
+    const int numThreads    = argc > 1 ? std::atoi(argv[1]) : 16;
+    const int numChans      = argc > 2 ? std::atoi(argv[2]) : 64;
+    const int numRoundTrips = argc > 3 ? std::atoi(argv[3]) : 100000;
+    assert(numThreads > 0);
+    assert(numChans > 0);
+    assert(numRoundTrips > 0);
+
+    // Every thread waits on every channel.  Each thread waits using one
+    // file, however many channels there are.
+    std::vector<chan::Chan<int> > chans(numChans);
+    std::vector<pthread_t>        threads(numThreads);
+
+    const int filesBefore = countOpenFiles();
+    for (int i = 0; i < numThreads; ++i) {
+        const int rc = pthread_create(&threads[i], 0, recvFromAny, &chans);
+        assert(rc == 0);
+        (void)rc;
+    }
+
+    usleep(100 * 1000);  // give them time to start waiting
+    std::cout << countOpenFiles() - filesBefore << " additional files open "
+              << "while " << numThreads << " threads wait on " << numChans
+              << " channels each\n";
+
+    for (int i = 0; i < numThreads; ++i) {
+        chans[i % numChans].send(i);
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        const int rc = pthread_join(threads[i], 0);
+        assert(rc == 0);
+        (void)rc;
+    }
+
+    // Measure the round trip between two threads, each of which wakes up the
+    // other once per trip.
+    chan::Chan<int> pair[2];
+    pthread_t       echoer;
+    int rc = pthread_create(&echoer, 0, echo, pair);
+    assert(rc == 0);
+
+    const chan::TimePoint before = chan::now();
+    for (int i = 0; i < numRoundTrips; ++i) {
+        pair[0].send(i);
+        const int value = pair[1].recv();
+        assert(value == i);
+        (void)value;
+    }
+    std::cout << (chan::now() - before) / numRoundTrips
+              << " per round trip between two threads\n";
+
+    pair[0].send(-1);
+    pair[1].recv();
+    rc = pthread_join(echoer, 0);
+    assert(rc == 0);
+    (void)rc;
+
+    return 0;
+}
+
+int testBackends(int argc, char* argv[]) {
+    const int numFiles      = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int numIterations = argc > 2 ? std::atoi(argv[2]) : 10000;
+    assert(numFiles > 0);
+    assert(numIterations > 0);
+
+    // The backends to compare are named by the remaining arguments, if any.
+    std::vector<std::string> backends(argv + std::min(argc, 3), argv + argc);
+    if (backends.empty()) {
+        backends.push_back("poll");
+        backends.push_back("epoll");
+        backends.push_back("uring");
+    }
+
+    std::vector<int>                       readEnds;
+    std::vector<int>                       writeEnds;
+    std::vector<chan::ReadIntoBufferEvent> reads;
+    char                                   buffer[1];
+
+    reads.reserve(numFiles);
+    for (int i = 0; i < numFiles; ++i) {
+        int       files[2];
+        const int rc = pipe(files);
+        assert(rc == 0);
+        (void)rc;
+        readEnds.push_back(files[0]);
+        writeEnds.push_back(files[1]);
+        reads.push_back(chan::read(files[0], buffer));
+    }
+
+    // A `SelectSet` selects repeatedly on the same files, which is where the
+    // backends differ.  Run this under `strace -c -f` to compare the number
+    // of system calls each makes.
+    for (std::size_t i = 0; i < backends.size(); ++i) {
+        setSelectBackend(backends[i]);
+
+        chan::SelectSet selectSet;
+        for (int j = 0; j < numFiles; ++j) {
+            selectSet.add(reads[j]);
+        }
+
+        std::cout << backends[i] << ": ";
+        SelectSetSelect repeatedly = {&selectSet};
+        if (timeSelections(repeatedly, writeEnds, numIterations)) {
+            return 1;
+        }
+        std::cout << " per SelectSet::select of " << numFiles << " files\n";
+    }
+
+    for (int i = 0; i < numFiles; ++i) {
+        ::close(readEnds[i]);
+        ::close(writeEnds[i]);
+    }
+
+    return 0;
+}
+
+// The argument to `echoSelecting`: a pair of channels as for `echo`, and a
+// file to include in each `select`, or -1 for none.
+struct EchoArgs {
+    chan::Chan<int> chans[2];
+    int             file;
+};
+
+// Select on the specified channel `event`, and also on reading the specified
+// `file` unless it's negative.  The behavior is undefined unless `event` is
+// the one fulfilled.
+template <typename EVENT>
+void selectWithFile(EVENT event, int file) {
+    char      buffer[1];
+    const int rc =
+        file < 0 ? select(event) : select(event, chan::read(file, buffer));
+    assert(rc == 0);
+    (void)rc;
+}
+
+// Do what `echo` does with the `chans` of the specified `EchoArgs`, but
+// using `selectWithFile`.
+void* echoSelecting(void* argsRaw) {
+    EchoArgs& args = *static_cast<EchoArgs*>(argsRaw);
+    for (;;) {
+        int value;
+        selectWithFile(args.chans[0].recv(&value), args.file);
+        selectWithFile(args.chans[1].send(value), args.file);
+        if (value < 0) {
+            return 0;
+        }
+    }
+}
+
+int testChanOnlySelect(int argc, char* argv[]) {
+    const int numRoundTrips = argc > 1 ? std::atoi(argv[1]) : 100000;
+    assert(numRoundTrips > 0);
+
+    // The pipe is never written to, so only the channels are ever ready.
+    int files[2];
+    int rc = pipe(files);
+    assert(rc == 0);
+
+    // A `select` involving nothing but channels waits on its thread's wakeup
+    // directly.  One that also involves a file has to poll it.  Run this
+    // under `strace -c -f` to compare the system calls each makes.
+    const char* const names[] = { "channels only", "channels and a file" };
+    for (int i = 0; i < 2; ++i) {
+        EchoArgs args;
+        args.file = i ? files[0] : -1;
+
+        pthread_t echoer;
+        rc = pthread_create(&echoer, 0, echoSelecting, &args);
+        assert(rc == 0);
+
+        const chan::TimePoint before = chan::now();
+        for (int j = 0; j < numRoundTrips; ++j) {
+            int value;
+            selectWithFile(args.chans[0].send(j), args.file);
+            selectWithFile(args.chans[1].recv(&value), args.file);
+            assert(value == j);
+            (void)value;
+        }
+        std::cout << names[i] << ": " << (chan::now() - before) / numRoundTrips
+                  << " per round trip between two threads\n";
+
+        int last;
+        selectWithFile(args.chans[0].send(-1), args.file);
+        selectWithFile(args.chans[1].recv(&last), args.file);
+        rc = pthread_join(echoer, 0);
+        assert(rc == 0);
+    }
+
+    ::close(files[0]);
+    ::close(files[1]);
+    (void)rc;
+    return 0;
+}
+
+// Receive values from the `CHAN` (e.g. `chan::Chan<int>`) pointed to by the
+// specified argument until receiving a negative value.
+template <typename CHAN>
+void* drain(void* chanRaw) {
+    CHAN& numbers = *static_cast<CHAN*>(chanRaw);
+    while (numbers.recv() >= 0) {
+    }
+    return 0;
+}
+
+int testBufferedChan(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 100000;
+    assert(numMessages > 0);
+
+    // A buffered channel preserves order, and can be used without waiting
+    // until it's full (or empty).
+    chan::Chan<std::string> words(2);
+    std::string             word = "hello";
+    words.send(&word);
+    words.send("world");
+    if (select(words.send("!"), chan::otherwise()) != 1) {
+        std::cerr << "expected a full buffer\n";
+        return 1;
+    }
+    if (words.recv() != "hello" || words.recv() != "world") {
+        std::cerr << "expected first in, first out\n";
+        return 1;
+    }
+
+    // Compare the cost of sending each message from one thread to another,
+    // where the sender doesn't otherwise wait, as the capacity grows.
+    const std::size_t capacities[] = { 0, 1, 16, 256 };
+    for (std::size_t i = 0; i < sizeof capacities / sizeof capacities[0];
+         ++i) {
+        chan::Chan<int> numbers(capacities[i]);
+        pthread_t       receiver;
+        int             rc = pthread_create(
+            &receiver, 0, drain<chan::Chan<int> >, &numbers);
+        assert(rc == 0);
+
+        const chan::TimePoint before = chan::now();
+        for (int j = 0; j < numMessages; ++j) {
+            numbers.send(j);
+        }
+        numbers.send(-1);
+        rc = pthread_join(receiver, 0);
+        assert(rc == 0);
+        (void)rc;
+
+        std::cout << "capacity " << numbers.capacity() << ": "
+                  << (chan::now() - before) / numMessages << " per message\n";
+    }
+
+    return 0;
+}
+
+// Send the specified `numMessages` integers, and then -1, on the specified
+// `numbers` to a thread that drains them, and print how long each took.
+template <typename CHAN>
+void timeDrain(CHAN& numbers, const char* label, int numMessages) {
+    pthread_t receiver;
+    int       rc = pthread_create(&receiver, 0, drain<CHAN>, &numbers);
+    assert(rc == 0);
+
+    const chan::TimePoint before = chan::now();
+    for (int j = 0; j < numMessages; ++j) {
+        numbers.send(j);
+    }
+    numbers.send(-1);
+    rc = pthread_join(receiver, 0);
+    assert(rc == 0);
+    (void)rc;
+
+    std::cout << label << " capacity " << numbers.capacity() << ": "
+              << (chan::now() - before) / numMessages << " per message\n";
+}
+
+int testSpscChan(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    assert(numMessages > 0);
+
+    // An `SpscChan` behaves like a buffered `Chan`.
+    chan::SpscChan<std::string> words(2);
+    std::string                 word = "hello";
+    words.send(&word);
+    words.send("world");
+    if (select(words.send("!"), chan::otherwise()) != 1) {
+        std::cerr << "expected a full buffer\n";
+        return 1;
+    }
+    if (words.recv() != "hello" || words.recv() != "world") {
+        std::cerr << "expected first in, first out\n";
+        return 1;
+    }
+
+    // Waiting on an empty `SpscChan` mixes with other events.
+    chan::Chan<>         done;
+    chan::SpscChan<char> letters(1);
+    char                 letter = 0;
+    switch (select(letters.recv(&letter),
+                   done.recv(),
+                   chan::timeout(chan::milliseconds(10)))) {
+        case 2:
+            break;
+        default:
+            std::cerr << "expected a timeout\n";
+            return 1;
+    }
+
+    // Compare the cost of sending each message from one thread to another
+    // with that of a buffered `Chan`.
+    const std::size_t capacities[] = { 16, 256, 4096 };
+    for (std::size_t i = 0; i < sizeof capacities / sizeof capacities[0];
+         ++i) {
+        chan::Chan<int> locked(capacities[i]);
+        timeDrain(locked, "Chan", numMessages);
+
+        chan::SpscChan<int> lockFree(capacities[i]);
+        timeDrain(lockFree, "SpscChan", numMessages);
+    }
+
+    return 0;
+}
+
+template <typename CHAN>
+struct SendManyArgs {
+    CHAN* numbers;
+    int   count;
+};
+
+// Send the integers from zero up to, but not including, `count` on
+// `numbers`, as specified by the `SendManyArgs<CHAN>` pointed to by the
+// specified argument.
+template <typename CHAN>
+void* sendMany(void* argsRaw) {
+    const SendManyArgs<CHAN>& args =
+        *static_cast<SendManyArgs<CHAN>*>(argsRaw);
+    for (int i = 0; i < args.count; ++i) {
+        args.numbers->send(i);
+    }
+    return 0;
+}
+
+// Send integers from each of the specified `numThreads` threads to each of
+// `numThreads` others on the specified `numbers`, the specified
+// `numMessages` in total, and print how long each message took.
+template <typename CHAN>
+void timeManyToMany(CHAN&       numbers,
+                    const char* label,
+                    int         numThreads,
+                    int         numMessages) {
+    std::vector<pthread_t> receivers(numThreads);
+    std::vector<pthread_t> senders(numThreads);
+    SendManyArgs<CHAN>     args = { &numbers, numMessages / numThreads };
+
+    const chan::TimePoint before = chan::now();
+    for (int i = 0; i < numThreads; ++i) {
+        int rc = pthread_create(&receivers[i], 0, drain<CHAN>, &numbers);
+        assert(rc == 0);
+        rc = pthread_create(&senders[i], 0, sendMany<CHAN>, &args);
+        assert(rc == 0);
+        (void)rc;
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        pthread_join(senders[i], 0);
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        numbers.send(-1);
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        pthread_join(receivers[i], 0);
+    }
+
+    std::cout << label << " with " << numThreads << " senders and "
+              << numThreads << " receivers: "
+              << (chan::now() - before) / (args.count * numThreads)
+              << " per message\n";
+}
+
+int testMpmcChan(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    assert(numMessages > 0);
+
+    // An `MpmcChan` behaves like a buffered `Chan`, though its capacity is
+    // rounded up to a power of two.
+    chan::MpmcChan<std::string> words(2);
+    std::string                 word = "hello";
+    words.send(&word);
+    words.send("world");
+    if (select(words.send("!"), chan::otherwise()) != 1) {
+        std::cerr << "expected a full buffer\n";
+        return 1;
+    }
+    if (words.recv() != "hello" || words.recv() != "world") {
+        std::cerr << "expected first in, first out\n";
+        return 1;
+    }
+
+    // Compare the cost of sending each message among several threads with
+    // that of a buffered `Chan`.
+    const int numThreads[] = { 1, 2, 4 };
+    for (std::size_t i = 0; i < sizeof numThreads / sizeof numThreads[0];
+         ++i) {
+        chan::Chan<int> locked(256);
+        timeManyToMany(locked, "Chan", numThreads[i], numMessages);
+
+        chan::MpmcChan<int> lockFree(256);
+        timeManyToMany(lockFree, "MpmcChan", numThreads[i], numMessages);
+    }
+
+    return 0;
+}
+
+int testManyWaiters(int argc, char* argv[]) {
+    const int numIterations = argc > 1 ? std::atoi(argv[1]) : 10;
+    assert(numIterations > 0);
+
+    // Each `selectRange` files every send on the same `Chan` before the
+    // `otherwise` is fulfilled, and then cancels them all, so that the
+    // channel has that many waiting senders to link and unlink.  The
+    // `SendEvent`s must not move once they're referred to by `EventRef`s,
+    // hence `reserve`.
+    const int numEvents[] = { 10, 100, 1000, 10000 };
+    for (std::size_t i = 0; i < sizeof numEvents / sizeof numEvents[0];
+         ++i) {
+        chan::Chan<int>                    numbers;
+        const int                          number = 0;
+        std::vector<chan::SendEvent<int> > sends;
+        std::vector<chan::EventRef>        events;
+
+        sends.reserve(numEvents[i]);
+        events.reserve(numEvents[i] + 1);
+        for (int j = 0; j < numEvents[i]; ++j) {
+            sends.push_back(numbers.send(number));
+            events.push_back(chan::EventRef(sends.back()));
+        }
+
+        chan::OtherwiseEvent otherwiseEvent = chan::otherwise();
+        events.push_back(chan::EventRef(otherwiseEvent));
+
+        const chan::TimePoint before = chan::now();
+        for (int j = 0; j < numIterations; ++j) {
+            if (chan::selectRange(events) != numEvents[i]) {
+                std::cerr << "expected nobody to receive\n";
+                return 1;
+            }
+        }
+
+        std::cout << (chan::now() - before) / numIterations
+                  << " per selectRange of " << numEvents[i]
+                  << " sends on the same Chan\n";
+    }
+
+    return 0;
+}
+
+int testMutexContention(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    assert(numMessages > 0);
+
+    // Every message sent on a `Chan` locks its `Mutex` at least twice, once
+    // on each side.  If the library was built with `CHAN_MUTEX_STATS`, show
+    // how often that found the `Mutex` locked, and how the wait ended.
+    const int numThreads[] = { 1, 2, 4, 8 };
+    for (std::size_t i = 0; i < sizeof numThreads / sizeof numThreads[0];
+         ++i) {
+#ifdef CHAN_MUTEX_STATS
+        const chan::MutexStats before = chan::mutexStats();
+#endif
+        chan::Chan<int> numbers(256);
+        timeManyToMany(numbers, "Chan", numThreads[i], numMessages);
+#ifdef CHAN_MUTEX_STATS
+        const chan::MutexStats after = chan::mutexStats();
+        std::cout << "    contended " << after.contended - before.contended
+                  << " times, of which " << after.spun - before.spun
+                  << " spun and " << after.slept - before.slept
+                  << " slept\n";
+#endif
+    }
+
+    return 0;
+}
+
+int testSingleEvent(int argc, char* argv[]) {
+    const int numIterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    assert(numIterations > 0);
+
+    // A `select` of one event takes the single-event path, while
+    // `selectRange` always uses the general one.  Compare them on a buffered
+    // `Chan`, whose sends and receives never wait here, and on a pipe that
+    // always has a byte to read.
+    chan::Chan<int> numbers(1);
+    int             number = 0;
+
+    chan::TimePoint before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        numbers.send(i);
+        numbers.recv(&number);
+    }
+    std::cout << (chan::now() - before) / numIterations
+              << " per send and recv through select of one event\n";
+
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::SendEvent<int> send = numbers.send(i);
+        chan::EventRef       sendRef(send);
+        chan::RecvEvent<int> recv = numbers.recv(&number);
+        chan::EventRef       recvRef(recv);
+        if (chan::selectRange(&sendRef, &sendRef + 1) ||
+            chan::selectRange(&recvRef, &recvRef + 1)) {
+            std::cerr << chan::lastError().what() << "\n";
+            return 1;
+        }
+    }
+    std::cout << (chan::now() - before) / numIterations
+              << " per send and recv through selectRange\n";
+
+    int files[2];
+    if (::pipe(files)) {
+        return 1;
+    }
+    char byte = 'x';
+
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::write(files[1], &byte, 1);
+        chan::read(files[0], &byte, 1);
+    }
+    std::cout << (chan::now() - before) / numIterations
+              << " per write and read through select of one event\n";
+
+    before = chan::now();
+    for (int i = 0; i < numIterations; ++i) {
+        chan::WriteFromBufferEvent write = chan::write(files[1], &byte, 1);
+        chan::EventRef             writeRef(write);
+        chan::ReadIntoBufferEvent  read = chan::read(files[0], &byte, 1);
+        chan::EventRef             readRef(read);
+        if (chan::selectRange(&writeRef, &writeRef + 1) ||
+            chan::selectRange(&readRef, &readRef + 1)) {
+            std::cerr << chan::lastError().what() << "\n";
+            return 1;
+        }
+    }
+    std::cout << (chan::now() - before) / numIterations
+              << " per write and read through selectRange\n";
+
+    ::close(files[0]);
+    ::close(files[1]);
+    return 0;
+}
+
+// Receive batches of values from the `chan::Chan<int>` pointed to by the
+// specified argument until receiving a negative value.
+void* drainBatches(void* chanRaw) {
+    chan::Chan<int>& numbers = *static_cast<chan::Chan<int>*>(chanRaw);
+    int              batch[64];
+    for (;;) {
+        const std::size_t count = numbers.recvUpTo(batch, 64);
+        if (batch[count - 1] < 0) {
+            return 0;
+        }
+    }
+}
+
+int testBatches(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    assert(numMessages > 0);
+
+    // On a buffered `Chan`, as many objects are sent as fit, and as many
+    // received as there are, in order.
+    chan::Chan<std::string> words(4);
+    const std::string       sentence[] = { "a", "b", "c", "d", "e", "f" };
+    if (words.sendMany(sentence, sentence + 6) != 4) {
+        std::cerr << "expected to fill the buffer\n";
+        return 1;
+    }
+    std::string received[8];
+    std::size_t numReceived;
+    words.recvUpTo(received, 8, &numReceived);
+    if (numReceived != 4 || received[0] != "a" || received[3] != "d") {
+        std::cerr << "expected to empty the buffer in order\n";
+        return 1;
+    }
+
+    // Batches are selectable like any other event.
+    if (select(words.recvUpTo(received, 8),
+               chan::deadline(chan::now() + chan::milliseconds(1))) != 1) {
+        std::cerr << "expected the deadline\n";
+        return 1;
+    }
+
+    // Compare sending and receiving one at a time with sending and receiving
+    // in batches of 64.
+    const std::size_t capacities[] = { 0, 256 };
+    for (std::size_t i = 0; i < sizeof capacities / sizeof capacities[0];
+         ++i) {
+        chan::Chan<int> numbers(capacities[i]);
+        pthread_t       receiver;
+        int             rc = pthread_create(
+            &receiver, 0, drain<chan::Chan<int> >, &numbers);
+        assert(rc == 0);
+
+        chan::TimePoint before = chan::now();
+        for (int j = 0; j < numMessages; ++j) {
+            numbers.send(j);
+        }
+        numbers.send(-1);
+        rc = pthread_join(receiver, 0);
+        assert(rc == 0);
+
+        std::cout << "capacity " << numbers.capacity() << " one at a time: "
+                  << (chan::now() - before) / numMessages << " per message\n";
+
+        rc = pthread_create(&receiver, 0, drainBatches, &numbers);
+        assert(rc == 0);
+
+        before = chan::now();
+        int batch[64];
+        for (int j = 0; j < numMessages; j += 64) {
+            const int batchSize = std::min(64, numMessages - j);
+            for (int k = 0; k < batchSize; ++k) {
+                batch[k] = j + k;
+            }
+
+            const int* next = batch;
+            while (next != batch + batchSize) {
+                next += numbers.sendMany(next, batch + batchSize);
+            }
+        }
+        numbers.send(-1);
+        rc = pthread_join(receiver, 0);
+        assert(rc == 0);
+        (void)rc;
+
+        std::cout << "capacity " << numbers.capacity() << " in batches: "
+                  << (chan::now() - before) / numMessages << " per message\n";
+    }
+
+    return 0;
+}
+
+// A `SlowCopy` takes a while to assign, as would a large object.
+struct SlowCopy {
+    int value;
+
+    SlowCopy()
+    : value() {
+    }
+
+    SlowCopy(const SlowCopy& other)
+    : value(other.value) {
+    }
+
+    SlowCopy& operator=(const SlowCopy& other) {
+        usleep(50 * 1000);
+        value = other.value;
+        return *this;
+    }
+};
+
+struct SlowTransferChans {
+    chan::Chan<SlowCopy> slow;
+    chan::Chan<int>      fast;
+};
+
+void* sendSlowly(void* chansRaw) {
+    SlowTransferChans& chans = *static_cast<SlowTransferChans*>(chansRaw);
+    usleep(10 * 1000);  // give the receiver time to start waiting
+
+    SlowCopy object;
+    object.value = 42;
+    chans.slow.send(object);
+    return 0;
+}
+
+void* tryToSendQuickly(void* chansRaw) {
+    SlowTransferChans& chans = *static_cast<SlowTransferChans*>(chansRaw);
+    usleep(20 * 1000);  // give the slow transfer time to start
+
+    const chan::TimePoint before = chan::now();
+    const int             rc =
+        select(chans.fast.send(7), chan::timeout(chan::milliseconds(1)));
+    std::cout << "send during the slow transfer: select returned " << rc
+              << " after " << (chan::now() - before) << "\n";
+    return 0;
+}
+
+int testSlowTransfer(int, char*[]) {
+    // A receiver waits on two channels.  One sender fulfills it on one of
+    // them, with an object that takes 50 milliseconds to copy, and meanwhile
+    // another tries briefly to send on the other.  The second sender finds
+    // the receiver already fulfilled, rather than waiting for the copy.
+    SlowTransferChans chans;
+    pthread_t         slowSender;
+    pthread_t         fastSender;
+    int rc = pthread_create(&slowSender, 0, sendSlowly, &chans);
+    assert(rc == 0);
+    rc = pthread_create(&fastSender, 0, tryToSendQuickly, &chans);
+    assert(rc == 0);
+
+    SlowCopy object;
+    int      number;
+    rc = select(chans.slow.recv(&object), chans.fast.recv(&number));
+    std::cout << "receiver: select returned " << rc << " with "
+              << object.value << "\n";
+
+    pthread_join(slowSender, 0);
+    pthread_join(fastSender, 0);
+    return rc == 0 && object.value == 42 ? 0 : 1;
+}
+
+#if __cplusplus >= 201402
+// A `Counted` has no default constructor, and counts how many times it's
+// constructed.
+struct Counted {
+    static int numConstructed;
+
+    int value;
+
+    explicit Counted(int value)
+    : value(value) {
+        ++numConstructed;
+    }
+
+    Counted(const Counted& other)
+    : value(other.value) {
+        ++numConstructed;
+    }
+
+    Counted(Counted&& other)
+    : value(other.value) {
+        ++numConstructed;
+    }
+
+    Counted& operator=(const Counted&) = default;
+    Counted& operator=(Counted&&)      = default;
+};
+
+int Counted::numConstructed = 0;
+
+void* emplaceCounted(void* chanRaw) {
+    chan::Chan<Counted>& chan = *static_cast<chan::Chan<Counted>*>(chanRaw);
+    chan.emplace(42);
+    return 0;
+}
+
+void* sendCounted(void* chanRaw) {
+    chan::Chan<Counted>& chan = *static_cast<chan::Chan<Counted>*>(chanRaw);
+    Counted              object(42);
+    chan.send(&object);
+    return 0;
+}
+
+// Receive one `Counted` on the specified `chan` from a thread running the
+// specified `sender`, and print how many were constructed along the way.
+// Return whether the right value arrived.
+bool countConstructions(const char*         description,
+                        chan::Chan<Counted> chan,
+                        void* (*sender)(void*)) {
+    Counted::numConstructed = 0;
+
+    pthread_t thread;
+    const int rc = pthread_create(&thread, 0, sender, &chan);
+    assert(rc == 0);
+    (void)rc;
+
+    chan::Optional<Counted> received;
+    chan.recv(&received);
+    pthread_join(thread, 0);
+
+    std::cout << description << ": " << Counted::numConstructed
+              << " construction(s)\n";
+    return received.hasValue() && received->value == 42;
+}
+#endif
+
+int testEmplace(int, char*[]) {
+#if __cplusplus >= 201402
+    // Each message is constructed once on an unbuffered channel when the
+    // sender emplaces and the receiver receives into an `Optional`.  A
+    // buffered channel adds a move out of the buffer.
+    bool ok = true;
+    ok &= countConstructions("unbuffered, emplace into Optional",
+                             chan::Chan<Counted>(),
+                             emplaceCounted);
+    ok &= countConstructions("unbuffered, send into Optional",
+                             chan::Chan<Counted>(),
+                             sendCounted);
+    ok &= countConstructions("buffered, emplace into Optional",
+                             chan::Chan<Counted>(1),
+                             emplaceCounted);
+
+    // `recv()` no longer needs a default constructor.
+    chan::Chan<Counted> chan(1);
+    chan.emplace(7);
+    const Counted received = chan.recv();
+    std::cout << "recv() returned " << received.value << "\n";
+    ok &= received.value == 7;
+
+    return ok ? 0 : 1;
+#else
+    std::cout << "emplace requires C++14\n";
+    return 0;
+#endif
+}
+
+// A `Quote` is the latest price of one of a few symbols.
+struct Quote {
+    int symbol;
+    int price;
+};
+
+int symbolOf(const Quote& quote) {
+    return quote.symbol;
+}
+
+const int numSymbols = 4;
+
+struct QuoteFeed {
+    chan::ConflatingChan<Quote, int> quotes;
+    int                              numMessages;
+    chan::Duration                   sendTime;
+
+    explicit QuoteFeed(int numMessages)
+    : quotes(symbolOf)
+    , numMessages(numMessages)
+    , sendTime() {
+    }
+};
+
+void* sendQuotes(void* feedRaw) {
+    QuoteFeed& feed = *static_cast<QuoteFeed*>(feedRaw);
+
+    const chan::TimePoint before = chan::now();
+    for (int i = 0; i < feed.numMessages; ++i) {
+        const Quote quote = { i % numSymbols, i };
+        feed.quotes.send(quote);
+    }
+    feed.sendTime = chan::now() - before;
+    return 0;
+}
+
+int testConflatingChan(int argc, char* argv[]) {
+    const int numMessages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    assert(numMessages >= numSymbols);
+
+    // Without a key, only the latest value is pending.
+    chan::ConflatingChan<int> latest;
+    latest.send(1);
+    latest.send(2);
+    latest.send(3);
+    int value;
+    if (latest.recv() != 3 ||
+        select(latest.recv(&value), chan::otherwise()) != 1) {
+        std::cerr << "expected only the latest value\n";
+        return 1;
+    }
+
+    // With a key, each key keeps its place in line.
+    chan::ConflatingChan<Quote, int> quotes(symbolOf);
+    const Quote sent[] = { { 0, 10 }, { 1, 20 }, { 0, 11 }, { 2, 30 },
+                           { 1, 21 } };
+    for (std::size_t i = 0; i < sizeof sent / sizeof sent[0]; ++i) {
+        quotes.send(sent[i]);
+    }
+    const int expected[][2] = { { 0, 11 }, { 1, 21 }, { 2, 30 } };
+    for (std::size_t i = 0; i < sizeof expected / sizeof expected[0]; ++i) {
+        const Quote quote = quotes.recv();
+        if (quote.symbol != expected[i][0] || quote.price != expected[i][1]) {
+            std::cerr << "expected the latest quote of each symbol in turn\n";
+            return 1;
+        }
+    }
+
+    // A receiver that takes a millisecond per quote doesn't slow down the
+    // sender, and ends up with the final quote of each symbol.
+    QuoteFeed feed(numMessages);
+    pthread_t sender;
+    const int rc = pthread_create(&sender, 0, sendQuotes, &feed);
+    assert(rc == 0);
+    (void)rc;
+
+    const int finalPrice  = numMessages - 1;
+    int       numFinal    = 0;
+    int       numReceived = 0;
+    while (numFinal < numSymbols) {
+        const Quote quote = feed.quotes.recv();
+        ++numReceived;
+        numFinal += quote.price > finalPrice - numSymbols;
+        usleep(1000);
+    }
+    pthread_join(sender, 0);
+
+    std::cout << "sent " << numMessages << " quotes in " << feed.sendTime
+              << " (" << feed.sendTime / numMessages << " each), received "
+              << numReceived << "\n";
+    return 0;
+}
+
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -464,6 +1808,44 @@ int main(int argc, char* argv[]) {
             return testWriteFromBuffer(argc, argv);
         case 11:
             return testFile(argc, argv);
+        case 12:
+            return testSelectAllocations(argc, argv);
+        case 13:
+            return testShuffleCost(argc, argv);
+        case 14:
+            return testSelectRange(argc, argv);
+        case 15:
+            return testManyDeadlines(argc, argv);
+        case 16:
+            return testTimeoutPrecision(argc, argv);
+        case 17:
+            return testOtherwise(argc, argv);
+        case 18:
+            return testBackends(argc, argv);
+        case 19:
+            return testWakeupFiles(argc, argv);
+        case 20:
+            return testChanOnlySelect(argc, argv);
+        case 21:
+            return testBufferedChan(argc, argv);
+        case 22:
+            return testSpscChan(argc, argv);
+        case 23:
+            return testMpmcChan(argc, argv);
+        case 24:
+            return testManyWaiters(argc, argv);
+        case 25:
+            return testMutexContention(argc, argv);
+        case 26:
+            return testSingleEvent(argc, argv);
+        case 27:
+            return testBatches(argc, argv);
+        case 28:
+            return testSlowTransfer(argc, argv);
+        case 29:
+            return testEmplace(argc, argv);
+        case 30:
+            return testConflatingChan(argc, argv);
         default:
             std::cerr << "Invalid test number " << testNum << "\n";
             return 1;
@@ -2,5 +2,8 @@
 #define INCLUDED_CHAN_CHAN
 
 #include <chan/chan/chan.h>
+#include <chan/chan/conflatingchan.h>
+#include <chan/chan/mpmcchan.h>
+#include <chan/chan/spscchan.h>
 
 #endif
@@ -3,29 +3,110 @@
 
 #include <chan/chanevents/recvevent.h>
 #include <chan/chanevents/sendevent.h>
+#include <chan/chanstate/optional.h>
 #include <chan/select/lasterror.h>
 #include <chan/select/select.h>
 #include <chan/threading/sharedptr.h>
 
+#include <cstddef>  // std::size_t
+#if __cplusplus >= 201103
+#include <utility>  // std::forward, std::move
+#endif
+
 namespace chan {
 
+// A `Chan` is unbuffered unless it's created with a nonzero capacity.  On an
+// unbuffered `Chan`, a send and a receive are fulfilled together, when a
+// sender and a receiver meet.  On a buffered `Chan`, a send is fulfilled once
+// its object is in the buffer, which it can be whenever the buffer isn't
+// full, and a receive is fulfilled once it has taken the oldest object out of
+// the buffer, which it can be whenever the buffer isn't empty.  Either way,
+// sends and receives can be selected upon along with any other events.
+//
+// A batch of objects can be sent using `sendMany`, and received using
+// `recvUpTo`, in one rendezvous, or one locking of the buffer, rather than one
+// per object.  Like `write` and `read` on a file, these transfer at least one
+// object, but maybe fewer than were asked for, and say how many.  If a
+// `sendMany` meets a `recvUpTo`, then as many objects are transferred as the
+// sender has or the receiver has room for, whichever is fewer.  Meeting a
+// `send` or a `recv`, one is.  On a buffered `Chan`, as many are transferred
+// as will fit in the buffer or are in it, respectively.  Trivially copyable
+// objects are copied using `std::memcpy` (C++11).
+//
+// An object can also be received by constructing it into an `Optional`, and
+// sent by constructing it, from arguments given to `emplace` (C++14), only
+// once it's known where it's going.  `OBJECT` then needn't be default
+// constructible, and, on an unbuffered `Chan`, an object emplaced by the
+// sender and received into an `Optional` is constructed exactly once, in the
+// receiver's `Optional`.  On a buffered `Chan`, it's constructed in the
+// buffer, and then moved into the `Optional`.
 template <typename OBJECT = void>
 class Chan {
     SharedPtr<ChanState<OBJECT> > state;
 
   public:
+    // Create an unbuffered `Chan`, or one whose buffer holds the specified
+    // `capacity` objects.
     Chan();
+    explicit Chan(std::size_t capacity);
+
+    std::size_t capacity() const;
 
     SendEvent<OBJECT> send(const OBJECT& copyFrom);
     SendEvent<OBJECT> send(OBJECT* moveFrom);
 
     RecvEvent<OBJECT> recv(OBJECT* destination);
-    OBJECT            recv();
+    RecvEvent<OBJECT> recv(Optional<OBJECT>* slot);
+
+    // Receive an object and return it.  This doesn't require `OBJECT` to be
+    // default constructible, except in C++98.
+    OBJECT recv();
+
+#if __cplusplus >= 201402
+    // Send an object constructed from the specified `args`, which are
+    // forwarded to its constructor when it's known where the object is going.
+    // The returned event refers to `args`, and so mustn't outlive the full
+    // expression that calls `emplace`.
+    template <typename... ARGS>
+    EmplaceEvent<OBJECT, ARGS...> emplace(ARGS&&... args);
+#endif
+
+    // Send as many of the objects in the specified range `[first, last)` as
+    // can be sent in one rendezvous, copying them from a `const` range or
+    // moving them from a non-`const` one, as `send` does.  Store the number
+    // sent into the optionally specified `numSent`, or return it if the event
+    // is converted to `std::size_t`.  The behavior is undefined unless
+    // `first < last`.
+    SendManyEvent<OBJECT> sendMany(const OBJECT* first,
+                                   const OBJECT* last,
+                                   std::size_t*  numSent = 0);
+    SendManyEvent<OBJECT> sendMany(OBJECT*      first,
+                                   OBJECT*      last,
+                                   std::size_t* numSent = 0);
+
+    // Receive into the consecutive objects at the specified `destination` up
+    // to the specified `maxCount` objects in one rendezvous.  Store the number
+    // received into the optionally specified `numReceived`, or return it if
+    // the event is converted to `std::size_t`.  The behavior is undefined
+    // unless `maxCount` is positive.
+    RecvUpToEvent<OBJECT> recvUpTo(OBJECT*      destination,
+                                   std::size_t  maxCount,
+                                   std::size_t* numReceived = 0);
 };
 
 template <typename OBJECT>
 Chan<OBJECT>::Chan()
-: state(new ChanState<OBJECT>()) {
+: state(makeShared<ChanState<OBJECT> >()) {
+}
+
+template <typename OBJECT>
+Chan<OBJECT>::Chan(std::size_t capacity)
+: state(makeShared<ChanState<OBJECT> >(capacity)) {
+}
+
+template <typename OBJECT>
+std::size_t Chan<OBJECT>::capacity() const {
+    return state->buffer.capacity();
 }
 
 template <typename OBJECT>
@@ -43,8 +124,53 @@ RecvEvent<OBJECT> Chan<OBJECT>::recv(OBJECT* destination) {
     return RecvEvent<OBJECT>(*state, destination);
 }
 
+template <typename OBJECT>
+RecvEvent<OBJECT> Chan<OBJECT>::recv(Optional<OBJECT>* slot) {
+    return RecvEvent<OBJECT>(*state, slot);
+}
+
+#if __cplusplus >= 201402
+template <typename OBJECT>
+template <typename... ARGS>
+EmplaceEvent<OBJECT, ARGS...> Chan<OBJECT>::emplace(ARGS&&... args) {
+    return EmplaceEvent<OBJECT, ARGS...>(*state, std::forward<ARGS>(args)...);
+}
+#endif
+
+template <typename OBJECT>
+SendManyEvent<OBJECT> Chan<OBJECT>::sendMany(const OBJECT* first,
+                                             const OBJECT* last,
+                                             std::size_t*  numSent) {
+    return SendManyEvent<OBJECT>(*state, first, last, numSent);
+}
+
+template <typename OBJECT>
+SendManyEvent<OBJECT> Chan<OBJECT>::sendMany(OBJECT*      first,
+                                             OBJECT*      last,
+                                             std::size_t* numSent) {
+    return SendManyEvent<OBJECT>(*state, first, last, numSent);
+}
+
+template <typename OBJECT>
+RecvUpToEvent<OBJECT> Chan<OBJECT>::recvUpTo(OBJECT*      destination,
+                                             std::size_t  maxCount,
+                                             std::size_t* numReceived) {
+    return RecvUpToEvent<OBJECT>(*state, destination, maxCount, numReceived);
+}
+
 template <typename OBJECT>
 OBJECT Chan<OBJECT>::recv() {
+#if __cplusplus >= 201103
+    Optional<OBJECT> result;
+    switch (select(this->recv(&result))) {
+        case 0:
+            return std::move(*result);
+        default:
+            throw lastError();
+    }
+#else
+    // Without move construction, it's cheaper to swap into a default
+    // constructed object than to copy out of an `Optional`.
     OBJECT result;
     switch (select(this->recv(&result))) {
         case 0:
@@ -52,6 +178,7 @@ OBJECT Chan<OBJECT>::recv() {
         default:
             throw lastError();
     }
+#endif
 }
 
 // `class Chan` is specialized for `void`, the default type.  `Chan<void>` is
@@ -66,13 +193,24 @@ class Chan<void> {
 
   public:
     Chan();
+    explicit Chan(std::size_t capacity);
+
+    std::size_t capacity() const;
 
     SendEvent<void> send();
     RecvEvent<void> recv();
 };
 
 inline Chan<void>::Chan()
-: state(new ChanState<void>()) {
+: state(makeShared<ChanState<void> >()) {
+}
+
+inline Chan<void>::Chan(std::size_t capacity)
+: state(makeShared<ChanState<void> >(capacity)) {
+}
+
+inline std::size_t Chan<void>::capacity() const {
+    return state->buffer.capacity();
 }
 
 inline SendEvent<void> Chan<void>::send() {
@@ -81,7 +219,8 @@ inline SendEvent<void> Chan<void>::send() {
 }
 
 inline RecvEvent<void> Chan<void>::recv() {
-    return RecvEvent<void>(*state, 0);
+    void* const null = 0;
+    return RecvEvent<void>(*state, null);
 }
 
 }  // namespace chan
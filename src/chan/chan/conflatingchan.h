@@ -0,0 +1,118 @@
+#ifndef INCLUDED_CHAN_CHAN_CONFLATINGCHAN
+#define INCLUDED_CHAN_CHAN_CONFLATINGCHAN
+
+#include <chan/chanevents/conflatingevent.h>
+#include <chan/chanstate/conflatingstate.h>
+#include <chan/chanstate/optional.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/select.h>
+#include <chan/threading/sharedptr.h>
+
+#include <cassert>
+#if __cplusplus >= 201103
+#include <utility>  // std::move
+#endif
+
+namespace chan {
+
+// A `ConflatingChan` is a channel on which only the latest value matters,
+// e.g. prices, where a slow receiver would rather skip to the freshest data
+// than have the sender wait for it.  A send never waits: it overwrites the
+// value that's pending, if any, or else makes its value pending.  A receive
+// waits until a value is pending, and takes it.  Sends and receives can be
+// selected upon along with any other events.
+//
+// By default the whole channel has one pending value.  Given a key function,
+// a `ConflatingChan` instead has one pending value per key, e.g. per stock
+// symbol, and a send overwrites only the pending value with the same key.
+// Receives then take values in the order in which their keys became pending,
+// so that a busy key can't starve the others.  Either way, the memory used is
+// bounded by the number of keys, not by how far behind the receivers are.
+//
+//     std::string symbolOf(const StockTick& tick) { return tick.symbol; }
+//
+//     chan::ConflatingChan<StockTick, std::string> ticks(symbolOf);
+template <typename OBJECT, typename KEY = void>
+class ConflatingChan {
+    SharedPtr<ConflatingState<OBJECT, KEY> > state;
+
+  public:
+    typedef KEY (*KeyFunction)(const OBJECT&);
+
+    // Create a `ConflatingChan` with one pending value.  The behavior is
+    // undefined unless `KEY` is `void`.
+    ConflatingChan();
+
+    // Create a `ConflatingChan` with one pending value per key, as returned
+    // by the specified `keyOf`, which must not be null.  `KEY` must be
+    // copyable and less-than comparable.
+    explicit ConflatingChan(KeyFunction keyOf);
+
+    ConflatingSendEvent<OBJECT, KEY> send(const OBJECT& copyFrom);
+    ConflatingSendEvent<OBJECT, KEY> send(OBJECT* moveFrom);
+
+    ConflatingRecvEvent<OBJECT, KEY> recv(OBJECT* destination);
+    ConflatingRecvEvent<OBJECT, KEY> recv(Optional<OBJECT>* slot);
+    OBJECT                           recv();
+};
+
+template <typename OBJECT, typename KEY>
+ConflatingChan<OBJECT, KEY>::ConflatingChan()
+: state(makeShared<ConflatingState<OBJECT, KEY> >()) {
+}
+
+template <typename OBJECT, typename KEY>
+ConflatingChan<OBJECT, KEY>::ConflatingChan(KeyFunction keyOf)
+: state(makeShared<ConflatingState<OBJECT, KEY> >(keyOf)) {
+    assert(keyOf);
+}
+
+template <typename OBJECT, typename KEY>
+ConflatingSendEvent<OBJECT, KEY> ConflatingChan<OBJECT, KEY>::send(
+    const OBJECT& copyFrom) {
+    return ConflatingSendEvent<OBJECT, KEY>(*state, &copyFrom);
+}
+
+template <typename OBJECT, typename KEY>
+ConflatingSendEvent<OBJECT, KEY> ConflatingChan<OBJECT, KEY>::send(
+    OBJECT* moveFrom) {
+    return ConflatingSendEvent<OBJECT, KEY>(*state, moveFrom);
+}
+
+template <typename OBJECT, typename KEY>
+ConflatingRecvEvent<OBJECT, KEY> ConflatingChan<OBJECT, KEY>::recv(
+    OBJECT* destination) {
+    return ConflatingRecvEvent<OBJECT, KEY>(*state, destination);
+}
+
+template <typename OBJECT, typename KEY>
+ConflatingRecvEvent<OBJECT, KEY> ConflatingChan<OBJECT, KEY>::recv(
+    Optional<OBJECT>* slot) {
+    return ConflatingRecvEvent<OBJECT, KEY>(*state, slot);
+}
+
+template <typename OBJECT, typename KEY>
+OBJECT ConflatingChan<OBJECT, KEY>::recv() {
+    // See `Chan::recv`.
+#if __cplusplus >= 201103
+    Optional<OBJECT> result;
+    switch (select(this->recv(&result))) {
+        case 0:
+            return std::move(*result);
+        default:
+            throw lastError();
+    }
+#else
+    OBJECT result;
+    switch (select(this->recv(&result))) {
+        case 0:
+            return result;
+        default:
+            throw lastError();
+    }
+#endif
+}
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1 @@
+#include <chan/chan/mpmcchan.h>
@@ -0,0 +1,82 @@
+#ifndef INCLUDED_CHAN_CHAN_MPMCCHAN
+#define INCLUDED_CHAN_CHAN_MPMCCHAN
+
+#include <chan/chanevents/mpmcevent.h>
+#include <chan/chanstate/mpmcstate.h>
+#include <chan/threading/sharedptr.h>
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+
+namespace chan {
+
+// An `MpmcChan` is a buffered channel for any number of sending and receiving
+// threads, meant for when many of them are busy at once.  Its sends and
+// receives behave like those of a buffered `Chan`, and can be selected upon
+// along with any other events, but while the buffer is neither full nor
+// empty, they don't lock anything: the buffer is a lock-free ring, and
+// senders and receivers contend only for the ring's positions.  Only a
+// thread that has to wait for the buffer, or that has to wake one that is
+// waiting, locks a mutex.
+//
+// The capacity of the buffer is rounded up to a power of two, and is at least
+// two.  `OBJECT`'s
+// move constructor and move assignment (in C++98, its default constructor and
+// swap) must not throw.
+template <typename OBJECT>
+class MpmcChan {
+    SharedPtr<MpmcState<OBJECT> > state;
+
+  public:
+    // Create an `MpmcChan` whose buffer holds at least the specified
+    // `capacity` objects.  The behavior is undefined unless `capacity` is
+    // positive.
+    explicit MpmcChan(std::size_t capacity);
+
+    std::size_t capacity() const;
+
+    MpmcSendEvent<OBJECT> send(const OBJECT& copyFrom);
+    MpmcSendEvent<OBJECT> send(OBJECT* moveFrom);
+
+    MpmcRecvEvent<OBJECT> recv(OBJECT* destination);
+    OBJECT                recv();
+};
+
+template <typename OBJECT>
+MpmcChan<OBJECT>::MpmcChan(std::size_t capacity)
+: state(makeShared<MpmcState<OBJECT> >(capacity)) {
+    assert(capacity > 0);
+}
+
+template <typename OBJECT>
+std::size_t MpmcChan<OBJECT>::capacity() const {
+    return state->capacity();
+}
+
+template <typename OBJECT>
+MpmcSendEvent<OBJECT> MpmcChan<OBJECT>::send(const OBJECT& copyFrom) {
+    return MpmcSendEvent<OBJECT>(*state, &copyFrom);
+}
+
+template <typename OBJECT>
+MpmcSendEvent<OBJECT> MpmcChan<OBJECT>::send(OBJECT* moveFrom) {
+    return MpmcSendEvent<OBJECT>(*state, moveFrom);
+}
+
+template <typename OBJECT>
+MpmcRecvEvent<OBJECT> MpmcChan<OBJECT>::recv(OBJECT* destination) {
+    return MpmcRecvEvent<OBJECT>(*state, destination);
+}
+
+template <typename OBJECT>
+OBJECT MpmcChan<OBJECT>::recv() {
+    // The event receives into `result` when it's destroyed, without calling
+    // `select` unless the ring is empty, and throws if that fails.
+    OBJECT result;
+    this->recv(&result);
+    return result;
+}
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1 @@
+#include <chan/chan/spscchan.h>
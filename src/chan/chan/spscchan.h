@@ -0,0 +1,81 @@
+#ifndef INCLUDED_CHAN_CHAN_SPSCCHAN
+#define INCLUDED_CHAN_CHAN_SPSCCHAN
+
+#include <chan/chanevents/spscevent.h>
+#include <chan/chanstate/spscstate.h>
+#include <chan/threading/sharedptr.h>
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+
+namespace chan {
+
+// An `SpscChan` is a buffered channel for when exactly one thread sends and
+// exactly one thread receives, e.g. a reader thread feeding a worker.  Its
+// sends and receives behave like those of a buffered `Chan`, and can be
+// selected upon along with any other events, but they never lock a mutex:
+// the buffer is a lock-free ring, and a send or receive touches the other
+// thread's `ThreadWakeup` only if that thread is waiting for the ring to
+// become not full or not empty, respectively.
+//
+// The behavior is undefined if two threads send at the same time, if two
+// threads receive at the same time, or if one `select` involves more than
+// one send (or more than one receive) on the same `SpscChan`.  Which thread
+// is the sender, or the receiver, can change over time, provided that the
+// threads synchronize with each other in between.
+template <typename OBJECT>
+class SpscChan {
+    SharedPtr<SpscState<OBJECT> > state;
+
+  public:
+    // Create an `SpscChan` whose buffer holds the specified `capacity`
+    // objects.  The behavior is undefined unless `capacity` is positive.
+    explicit SpscChan(std::size_t capacity);
+
+    std::size_t capacity() const;
+
+    SpscSendEvent<OBJECT> send(const OBJECT& copyFrom);
+    SpscSendEvent<OBJECT> send(OBJECT* moveFrom);
+
+    SpscRecvEvent<OBJECT> recv(OBJECT* destination);
+    OBJECT                recv();
+};
+
+template <typename OBJECT>
+SpscChan<OBJECT>::SpscChan(std::size_t capacity)
+: state(makeShared<SpscState<OBJECT> >(capacity)) {
+    assert(capacity > 0);
+}
+
+template <typename OBJECT>
+std::size_t SpscChan<OBJECT>::capacity() const {
+    return state->capacity();
+}
+
+template <typename OBJECT>
+SpscSendEvent<OBJECT> SpscChan<OBJECT>::send(const OBJECT& copyFrom) {
+    return SpscSendEvent<OBJECT>(*state, &copyFrom);
+}
+
+template <typename OBJECT>
+SpscSendEvent<OBJECT> SpscChan<OBJECT>::send(OBJECT* moveFrom) {
+    return SpscSendEvent<OBJECT>(*state, moveFrom);
+}
+
+template <typename OBJECT>
+SpscRecvEvent<OBJECT> SpscChan<OBJECT>::recv(OBJECT* destination) {
+    return SpscRecvEvent<OBJECT>(*state, destination);
+}
+
+template <typename OBJECT>
+OBJECT SpscChan<OBJECT>::recv() {
+    // The event receives into `result` when it's destroyed, without calling
+    // `select` unless the ring is empty, and throws if that fails.
+    OBJECT result;
+    this->recv(&result);
+    return result;
+}
+
+}  // namespace chan
+
+#endif
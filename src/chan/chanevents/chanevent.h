@@ -4,21 +4,25 @@
 // TODO: explain it's a generic blah blah...
 
 #include <chan/chanevents/chanprotocol.h>
-#include <chan/chanevents/fulfillmentlockguard.h>
+#include <chan/chanevents/fulfillmentclaim.h>
 #include <chan/chanstate/chanstate.h>
+#include <chan/chanstate/waiterlist.h>
 #include <chan/debug/trace.h>
 #include <chan/errors/error.h>
 #include <chan/errors/errorcode.h>
 #include <chan/errors/noexcept.h>
 #include <chan/errors/uncaughtexceptions.h>
 #include <chan/event/ioevent.h>
+#include <chan/files/threadwakeup.h>
 #include <chan/select/lasterror.h>
 #include <chan/select/select.h>
+#include <chan/select/selectone.h>
 #include <chan/threading/lockguard.h>
 
-#include <algorithm>  // std::swap, std::find_if
+#include <algorithm>  // std::copy, std::min, std::swap
 #include <cassert>
-#include <list>
+#include <cstddef>  // std::size_t
+#include <cstring>  // std::memcpy
 #include <utility>  // std::move (if C++11)
 
 namespace chan {
@@ -30,10 +34,14 @@ class ChanEvent {
     typedef typename POLICY::Teammate Teammate;
     typedef typename POLICY::Opponent Opponent;
 
+  protected:
+    Teammate me;
+
   private:
-    Teammate     me;
-    Opponent     them;  // used when I'm a visitor (as opposed to a sitter)
-    State&       chanState;
+    Opponent them;  // used when I'm a visitor (as opposed to a sitter)
+    State&   chanState;
+
+  protected:
     mutable bool selectOnDestroy;
 
   public:
@@ -49,39 +57,142 @@ class ChanEvent {
   private:
     IoEvent attemptTransfer();
     void    cleanup();
+
+    // The counterparts of `file` and `fulfill` for buffered channels.
+    IoEvent fileBuffered();
+    IoEvent fulfillBuffered(IoEvent event);
+
+    // Attempt to transfer between me and `chanState.buffer`, and if that
+    // succeeds, poke the first waiting opponent that isn't already poked, and
+    // return `true`.  Load into the specified `toWake` the wakeup, if any, to
+    // post for that opponent after `chanState.mutex` is released.
+    // `chanState.mutex` must be locked.
+    bool tryBuffer(ThreadWakeup** toWake);
+
+    // Send the specified `message` to `them`, whom I've already marked
+    // fulfilled, and wake up their thread if necessary.
+    void notifyThem(ChanProtocolMessage message);
 };
 
+// Store the specified `count` into `*participant.numTransferred`, if it's
+// not null.
+inline void recordTransfer(const ChanParticipant& participant,
+                           std::size_t            count) {
+    if (participant.numTransferred) {
+        *participant.numTransferred = count;
+    }
+}
+
+// Construct into the specified `slot` the one object that the specified
+// `sender` sends: a move (copy, in C++98) or a copy of the sender's object,
+// or, for an `EMPLACE` sender, the object itself.
+template <typename OBJECT>
+void constructFrom(const ChanSender<OBJECT>& sender, Optional<OBJECT>* slot) {
+    assert(slot);
+
+    switch (sender.transferMode) {
+        case ChanSender<OBJECT>::MOVE:
+            assert(sender.moveFrom);
+#if __cplusplus >= 201103
+            slot->emplace(std::move(*sender.moveFrom));
+#else
+            slot->emplace(*sender.moveFrom);
+#endif
+            break;
+        case ChanSender<OBJECT>::COPY:
+            assert(sender.copyFrom);
+            slot->emplace(*sender.copyFrom);
+            break;
+        default:
+            assert(sender.transferMode == ChanSender<OBJECT>::EMPLACE);
+            slot->emplaceUsing(sender.emplacer);
+    }
+}
+
 // Transferring an `OBJECT` between a sender and a receiver can be expressed as
 // a non-member function template.  There is also a special overload for
-// `void`, since `void` channels never transfer objects.
+// `void`, since `void` channels never transfer objects.  Either side might
+// have more than one object to transfer, in which case as many are
+// transferred as the other side has, or has room for.  A `CONSTRUCT`
+// receiver, or an `EMPLACE` sender, has only the one.
 template <typename OBJECT>
 void transfer(const ChanSender<OBJECT>&   sender,
               const ChanReceiver<OBJECT>& receiver) {
+    if (receiver.transferMode == ChanReceiver<OBJECT>::CONSTRUCT) {
+        constructFrom(sender, receiver.slot);
+        recordTransfer(sender, 1);
+        recordTransfer(receiver, 1);
+        return;
+    }
+
+    assert(receiver.transferMode == ChanReceiver<OBJECT>::ASSIGN);
     assert(receiver.destination);
 
+    if (sender.transferMode == ChanSender<OBJECT>::EMPLACE) {
+        // The receiver has an object already, so the best that can be done
+        // is to construct a temporary and move it there.
+        Optional<OBJECT> temporary;
+        temporary.emplaceUsing(sender.emplacer);
+#if __cplusplus >= 201103
+        *receiver.destination = std::move(*temporary);
+#else
+        using std::swap;
+        swap(*receiver.destination, *temporary);
+#endif
+        recordTransfer(sender, 1);
+        recordTransfer(receiver, 1);
+        return;
+    }
+
+    const std::size_t count = std::min(sender.count, receiver.count);
+    assert(count);
+
     if (sender.transferMode == ChanSender<OBJECT>::MOVE) {
         assert(sender.moveFrom);
 
+        if (isTriviallyCopyable<OBJECT>()) {
+            std::memcpy(static_cast<void*>(receiver.destination),
+                        sender.moveFrom,
+                        count * sizeof(OBJECT));
+        }
+        else {
+            for (std::size_t i = 0; i < count; ++i) {
 #if __cplusplus >= 201103
-        *receiver.destination = std::move(*sender.moveFrom);
+                receiver.destination[i] = std::move(sender.moveFrom[i]);
 #else
-        using std::swap;
-        swap(*receiver.destination, *sender.moveFrom);
+                using std::swap;
+                swap(receiver.destination[i], sender.moveFrom[i]);
 #endif
+            }
+        }
     }
     else {
         assert(sender.transferMode == ChanSender<OBJECT>::COPY);
         assert(sender.copyFrom);
 
-        *receiver.destination = *sender.copyFrom;
+        if (isTriviallyCopyable<OBJECT>()) {
+            std::memcpy(static_cast<void*>(receiver.destination),
+                        sender.copyFrom,
+                        count * sizeof(OBJECT));
+        }
+        else {
+            std::copy(sender.copyFrom,
+                      sender.copyFrom + count,
+                      receiver.destination);
+        }
     }
+
+    recordTransfer(sender, count);
+    recordTransfer(receiver, count);
 }
 
 // `Chan<void>` is special.  No transfer takes place on such channels.
 inline void transfer(const ChanSender<void>&   sender,
                      const ChanReceiver<void>& receiver) {
-    // By convention, `receiver.destination` is null, `sender.transferMode` is
-    // `MOVE`, and `sender.moveFrom` is null.  There's nothing to do here.
+    // By convention, `receiver.transferMode` is `ASSIGN`,
+    // `receiver.destination` is null, `sender.transferMode` is `MOVE`, and
+    // `sender.moveFrom` is null.  There's nothing to do here.
+    assert(receiver.transferMode == ChanReceiver<void>::ASSIGN);
     assert(!receiver.destination);
     assert(sender.transferMode == ChanSender<void>::MOVE);
     assert(!sender.moveFrom);
@@ -97,6 +208,71 @@ void transfer(const ChanReceiver<OBJECT>& receiver,
     transfer(sender, receiver);
 }
 
+// On a buffered channel, senders transfer into the buffer, and receivers
+// transfer out of it.
+template <typename OBJECT>
+void transfer(const ChanSender<OBJECT>& sender, ChanBuffer<OBJECT>& buffer) {
+    if (sender.count == 1) {
+        switch (sender.transferMode) {
+            case ChanSender<OBJECT>::MOVE:
+                assert(sender.moveFrom);
+                buffer.pushMove(*sender.moveFrom);
+                break;
+            case ChanSender<OBJECT>::COPY:
+                assert(sender.copyFrom);
+                buffer.pushCopy(*sender.copyFrom);
+                break;
+            default:
+                assert(sender.transferMode == ChanSender<OBJECT>::EMPLACE);
+                buffer.emplaceUsing(sender.emplacer);
+        }
+
+        recordTransfer(sender, 1);
+        return;
+    }
+
+    std::size_t count;
+    if (sender.transferMode == ChanSender<OBJECT>::MOVE) {
+        count = buffer.pushMoves(sender.moveFrom, sender.count);
+    }
+    else {
+        assert(sender.transferMode == ChanSender<OBJECT>::COPY);
+        count = buffer.pushCopies(sender.copyFrom, sender.count);
+    }
+
+    assert(count);
+    recordTransfer(sender, count);
+}
+
+template <typename OBJECT>
+void transfer(ChanBuffer<OBJECT>&          buffer,
+              const ChanReceiver<OBJECT>& receiver) {
+    if (receiver.transferMode == ChanReceiver<OBJECT>::CONSTRUCT) {
+        buffer.pop(receiver.slot);
+        recordTransfer(receiver, 1);
+        return;
+    }
+
+    if (receiver.count == 1) {
+        buffer.pop(receiver.destination);
+        recordTransfer(receiver, 1);
+        return;
+    }
+
+    const std::size_t count =
+        buffer.popMany(receiver.destination, receiver.count);
+    assert(count);
+    recordTransfer(receiver, count);
+}
+
+inline void transfer(const ChanSender<void>&, ChanBuffer<void>& buffer) {
+    buffer.push();
+}
+
+inline void transfer(ChanBuffer<void>& buffer, const ChanReceiver<void>&) {
+    buffer.pop();
+}
+
 template <typename POLICY>
 ChanEvent<POLICY>::ChanEvent(State& chanState, const Teammate& me)
 : me(me)
@@ -117,7 +293,7 @@ ChanEvent<POLICY>::ChanEvent(const ChanEvent& other)
 template <typename POLICY>
 ChanEvent<POLICY>::~ChanEvent() CHAN_THROWS {
     if (selectOnDestroy && !uncaughtExceptions()) {
-        if (select(*this)) {
+        if (selectOne(EventRef(*this))) {
             throw lastError();
         }
     }
@@ -135,37 +311,38 @@ IoEvent ChanEvent<POLICY>::file(const EventContext& context) {
     // We don't get `EventContext` until `file` is called on us by `select`.
     me.context = context;
 
-    // I'll be adding myself to the list of teammates, so first I need to
-    // allocate pipe and a node for the list.
-    me.pipe = chanState.pipePool.allocate();
+    if (POLICY::isBuffered(chanState)) {
+        return fileBuffered();
+    }
 
-    std::list<Teammate> oneNode;
-    oneNode.push_back(me);
+    // I'll be adding myself to the list of teammates, so first I need to
+    // allocate a mailbox.  `me` is the list's node.
+    me.mailbox = chanState.mailboxPool.allocate();
 
-    // Now add the node to the list of teammates, and based on what I see in
-    // the `ChanState`, begin the protocol as either a "sitter" or as a
-    // "visitor."
+    // Now add me to the list of teammates, and based on what I see in the
+    // `ChanState`, begin the protocol as either a "sitter" or as a "visitor."
     CHAN_WITH_LOCK(chanState.mutex) {
-        std::list<Teammate>& teammates = POLICY::teammates(chanState);
-        teammates.splice(teammates.end(), oneNode);
+        WaiterList<Teammate>& teammates = POLICY::teammates(chanState);
+        teammates.push_back(me);
 
-        const std::list<Opponent>& opponents = POLICY::opponents(chanState);
+        const WaiterList<Opponent>& opponents = POLICY::opponents(chanState);
         if (teammates.size() == 1 && !opponents.empty()) {
             // I'm a visitor.  After copying into `them` the `Opponent` I'll be
             // visiting, unlock the channel and attempt to transfer a value.
             CHAN_TRACE("I'm a visitor on channel ", &chanState);
 
             them = opponents.front();
-            ++them.pipe->referenceCount;
+            ++them.mailbox->referenceCount;
         }
         else {
             // I'm a sitter.  The `IoEvent` is to wait for a visitor to contact
-            // me.
+            // me, which it does by waking up my thread.
             CHAN_TRACE("I'm a sitter on channel ", &chanState);
 
             IoEvent waitForVisitor;
-            waitForVisitor.read = true;
-            waitForVisitor.file = me.pipe->fromVisitor;
+            waitForVisitor.read         = true;
+            waitForVisitor.notification = true;
+            waitForVisitor.file         = me.mailbox->wakeup->waitFile;
             return waitForVisitor;
         }
     }  // CHAN_WITH_LOCK(chanState.mutex)
@@ -178,42 +355,43 @@ IoEvent ChanEvent<POLICY>::file(const EventContext& context) {
 template <typename POLICY>
 IoEvent ChanEvent<POLICY>::attemptTransfer() {
     // `attemptTransfer` assumes that we're a visitor, so both `me` and
-    // `them` must be valid.  One way to check this is to check the `Pipe*`
+    // `them` must be valid.  One way to check this is to check the `Mailbox*`
     // members.
-    assert(me.pipe);
-    assert(them.pipe);
+    assert(me.mailbox);
+    assert(them.mailbox);
 
     IoEvent event;
-    event.read = true;
-    event.file = me.pipe->fromVisitor;
+    event.read         = true;
+    event.notification = true;
+    event.file         = me.mailbox->wakeup->waitFile;
 
-    CHAN_TRACE("About to lock for visitation.  me.context=",
+    CHAN_TRACE("About to claim for visitation.  me.context=",
                me.context,
                " them.context=",
                them.context);
 
-    FulfillmentLockGuard lock(me.context.fulfillment->mutex,
-                              them.context.fulfillment->mutex);
+    // My `select` has claimed my `SelectorFulfillment` on my behalf.  Claim
+    // theirs, too.
+    FulfillmentClaim claim(me.context, them.context);
 
-    CHAN_TRACE("Got lock for visitation.  me.context=",
+    CHAN_TRACE("Got claim for visitation.  me.context=",
                me.context,
                " them.context=",
                them.context);
 
-    if (me.context.fulfillment->state != SelectorFulfillment::FULFILLABLE) {
-        // While I was acquiring `lock`, above, another event snuck in and
+    if (!claim.mineIsClaimed()) {
+        // While I was claiming theirs, above, another event snuck in and
         // fulfilled one of the events in my `select` statement.  We're
         // done.
 
         // `select` won't act on the `IoEvent` we return, but return an
-        // `IoEvent` as if we were becoming a sitter, so that when `cancel` is
-        // called on us later, we can read from the appropriate file.
+        // `IoEvent` as if we were becoming a sitter.
         CHAN_TRACE("Somebody fulfilled me while I was visiting in channel ",
                    &chanState);
         return event;
     }
 
-    if (them.context.fulfillment->state != SelectorFulfillment::FULFILLABLE) {
+    if (!claim.theirsIsClaimed()) {
         // Some event in their `select` statement has already been fulfilled,
         // or they're handling an error.
         // I will become a sitter, because if there's anyone after them I could
@@ -224,127 +402,124 @@ IoEvent ChanEvent<POLICY>::attemptTransfer() {
     }
 
     // Neither their `select` nor my `select` has had an event fulfilled on
-    // it, so I will attempt a value transfer.
+    // it, and nobody else can fulfill either while we have the claims, so the
+    // two events are a match.  Mark both fulfilled now, and only then
+    // transfer, so that nobody waiting to claim either `SelectorFulfillment`
+    // waits for the transfer, however long it takes.  The sitter, once it
+    // notices, waits for me to say how the transfer went.
+    claim.fulfillBoth();
     try {
-        assert(me.context.fulfillment);
-        assert(them.context.fulfillment);
-
-        me.context.fulfillment->state = SelectorFulfillment::FULFILLED;
-        me.context.fulfillment->fulfilledEventKey = me.context.eventKey;
-
-        them.context.fulfillment->state = SelectorFulfillment::FULFILLED;
-        them.context.fulfillment->fulfilledEventKey = them.context.eventKey;
-
         transfer(me, them);
     }
     catch (...) {
         // Notify the sitter that the transfer failed, and then rethrow
         // the exception.
-        writeMessage(them.pipe->toSitter, ChanProtocolMessage::ERROR);
-        lock.unlock();
+        notifyThem(ChanProtocolMessage::ERROR);
         cleanup();
         throw;
     }
 
     // We did it!
-    writeMessage(them.pipe->toSitter, ChanProtocolMessage::DONE);
-    lock.unlock();
+    notifyThem(ChanProtocolMessage::DONE);
     cleanup();
 
     // Indicate to `select` that we are fulfilled by setting `event.fulfilled`.
-    // This is redundant, since we set `me.context.fulfillment` accordingly,
-    // above, but might as well be consistent.
     event.fulfilled = true;
     return event;
 }
 
+template <typename POLICY>
+void ChanEvent<POLICY>::notifyThem(ChanProtocolMessage message) {
+    // They're already fulfilled, whether or not the transfer succeeded, so
+    // their `select` takes the message.  `them.mailbox` outlives this call,
+    // since I hold a reference to it.
+    if (sendMessage(*them.mailbox, message)) {
+        postWakeup(*them.mailbox->wakeup);
+    }
+}
+
 template <typename POLICY>
 IoEvent ChanEvent<POLICY>::fulfill(IoEvent event) {
     assert(event.read);
-    assert(event.file == me.pipe->fromVisitor);
+    assert(event.file == me.mailbox->wakeup->waitFile);
 
-    // If we get poked and discover that a former `them`'s `Pipe`'s reference
-    // count has gone to zero, we will deallocate the `Pipe` only _after_ we've
-    // unlocked the `ChanState`'s mutex.  Hence this variable.
-    Pipe* pipeToDeallocate = 0;
+    if (POLICY::isBuffered(chanState)) {
+        return fulfillBuffered(event);
+    }
+
+    // If we get poked and discover that a former `them`'s `Mailbox`'s
+    // reference count has gone to zero, we will deallocate the `Mailbox` only
+    // _after_ we've unlocked the `ChanState`'s mutex.  Hence this variable.
+    Mailbox* mailboxToDeallocate = 0;
 
     CHAN_TRACE("In fulfill handling event: ", event);
-    // Since we know that `event.file` is a pipe created by this library, and
-    // since the code in this component manages what happens with such pipes,
-    // we can assume that none of `hangup`, `error`, or `invalid` will ever
-    // happen.
+    // Since we know that `event.file` is a thread's wakeup file, and since
+    // the code in this library manages what happens with such files, we can
+    // assume that none of `hangup`, `error`, or `invalid` will ever happen.
     assert(!event.hangup);
     assert(!event.error);
     assert(!event.invalid);
 
-    switch (const ChanProtocolMessage message = readMessage(event.file)) {
-        // case ChanProtocolMessage::DONE:
-        // `fulfill` will never get called by `select` due to receiving a
-        // `DONE` message, because if `select` wakes up and sees that
-        // something was fulfilled, it won't handle the event.
-        case ChanProtocolMessage::ERROR:
-            // An exception was thrown on the other end of the channel during
-            // the transfer.  We don't know what exactly, but we can report
-            // that something went wrong.  The thread on the other side of the
-            // channel will throw the original exception.
-            CHAN_TRACE("About to call cleanup() after handling ERROR in ",
+    // `DONE` and `ERROR` are sent only to an event that's already fulfilled,
+    // and `select` calls `fulfill` only while it has a claim on its
+    // `SelectorFulfillment`, so never after that.  They're taken in `cancel`
+    // instead.
+    assert(me.context.fulfillment->fulfilledEventKey(me.context.generation) ==
+           SelectorFulfillment::CLAIMED);
+
+    {
+        LockGuard lock(chanState.mutex);
+
+        if (!takeMessage(*me.mailbox, ChanProtocolMessage::POKE)) {
+            // Every channel event in this `select` shares the thread's wakeup
+            // file, so the wakeup was for one of the others.  Keep waiting.
+            CHAN_TRACE("Woken up for some other event, not me, in ",
                        &chanState);
-            cleanup();
-            throw Error(ErrorCode::TRANSFER);
-        default: {
-            assert(message == ChanProtocolMessage::POKE);
-            CHAN_TRACE("Handling a POKE in ", &chanState);
-            // We were waiting for a visitor to greet us, but instead
-            // somebody informs us that we are one of two sitters waiting
-            // for nobody, and so they poked us so that we will play the
-            // visitor role with the other sitter. Of course, it could be
-            // that by the time we get around to locking `chanState`,
-            // things have changed.  So we might end up remaining a sitter
-            // after all.
-            LockGuard lock(chanState.mutex);
-
-            std::list<Teammate>& teammates = POLICY::teammates(chanState);
-            const std::list<Opponent>& opponents =
-                POLICY::opponents(chanState);
-
-            // Assert that we are at the front of `teammates`.  Checking
-            // the `Pipe*` suffices.  Also check that we were poked.
-            assert(!teammates.empty());
-            assert(teammates.front().pipe == me.pipe);
-            assert(teammates.front().isPoked);
-            (void)teammates;  // unused variable when assertions are disabled
-
-            teammates.front().isPoked = false;  // we're handling it now
-
-            if (!opponents.empty() && !opponents.front().isPoked) {
-                // There's an opponent we can visit.
-                CHAN_TRACE("Found opponent while handling POKE in ",
-                           &chanState);
-
-                // I'm about to designate `them`.  If I've already done
-                // this before, then now's the time to reduce the reference
-                // count of the `pipe` of the previous `them`.  In either
-                // case, I'll increase the reference count of the new
-                // `them`.
-                if (them.pipe && --them.pipe->referenceCount == 0) {
-                    CHAN_TRACE("Decremented their pipe ",
-                               them.pipe,
-                               " down to ",
-                               them.pipe->referenceCount);
-                    pipeToDeallocate = them.pipe;
-                }
+            return event;
+        }
 
-                them = opponents.front();
-                ++them.pipe->referenceCount;
-            }
-            else {
-                // Either there's no one to visit, or the only candidate
-                // has also been poked.  So, we remain a sitter (event
-                // unchanged).
-                CHAN_TRACE("No opponent or also poked while handling POKE in ",
-                           &chanState);
-                return event;
+        // We were waiting for a visitor to greet us, but instead somebody
+        // informs us that we are one of two sitters waiting for nobody, and
+        // so they poked us so that we will play the visitor role with the
+        // other sitter.  Of course, it could be that by the time we got
+        // around to locking `chanState`, things have changed.  So we might
+        // end up remaining a sitter after all.
+        CHAN_TRACE("Handling a POKE in ", &chanState);
+
+        const WaiterList<Opponent>& opponents = POLICY::opponents(chanState);
+
+        // Assert that we are at the front of `teammates`, and that we were
+        // poked.
+        assert(&POLICY::teammates(chanState).front() == &me);
+        assert(me.isPoked);
+
+        me.isPoked = false;  // we're handling it now
+
+        if (!opponents.empty() && !opponents.front().isPoked) {
+            // There's an opponent we can visit.
+            CHAN_TRACE("Found opponent while handling POKE in ", &chanState);
+
+            // I'm about to designate `them`.  If I've already done this
+            // before, then now's the time to reduce the reference count of
+            // the `mailbox` of the previous `them`.  In either case, I'll
+            // increase the reference count of the new `them`.
+            if (them.mailbox && --them.mailbox->referenceCount == 0) {
+                CHAN_TRACE("Decremented their mailbox ",
+                           them.mailbox,
+                           " down to ",
+                           them.mailbox->referenceCount);
+                mailboxToDeallocate = them.mailbox;
             }
+
+            them = opponents.front();
+            ++them.mailbox->referenceCount;
+        }
+        else {
+            // Either there's no one to visit, or the only candidate has also
+            // been poked.  So, we remain a sitter (event unchanged).
+            CHAN_TRACE("No opponent or also poked while handling POKE in ",
+                       &chanState);
+            return event;
         }
     }
 
@@ -353,26 +528,37 @@ IoEvent ChanEvent<POLICY>::fulfill(IoEvent event) {
     event = attemptTransfer();
     CHAN_TRACE("Returned from attemptTransfer()");
 
-    if (pipeToDeallocate) {
-        chanState.pipePool.deallocate(pipeToDeallocate);
+    if (mailboxToDeallocate) {
+        chanState.mailboxPool.deallocate(mailboxToDeallocate);
     }
 
     return event;
 }
 
 template <typename POLICY>
-void ChanEvent<POLICY>::cancel(IoEvent ioEvent) {
-    // If I'm the fulfilled one, I'm guaranteed to have been sent a
-    // message.  I can check it now to determine whether it's an `ERROR`.
-    // Otherwise, just `cleanup`.
-    if (me.context.fulfillment->state == SelectorFulfillment::FULFILLED &&
-        me.context.fulfillment->fulfilledEventKey == me.context.eventKey) {
-        CHAN_TRACE("About to read from cancel because I was the one "
+void ChanEvent<POLICY>::cancel(IoEvent) {
+    if (!me.mailbox) {
+        // My `fulfill` already cleaned up before throwing an exception, and
+        // now my `select` is unwinding.  There's nothing left to do.
+        return;
+    }
+
+    // If I'm the fulfilled one, then a visitor is transferring with me, or
+    // has, and will send me a message saying whether it worked.  I must wait
+    // for it before my objects go away.  This is so even if my `select` is
+    // unwinding due to an error, since then my `SelectorFulfillment` stays
+    // fulfilled (see `SelectorFulfillment::forbid`).  Otherwise, nobody will
+    // send me `DONE` or `ERROR`, so just `cleanup`.
+    const EventContext& context = me.context;
+    if (context.fulfillment->fulfilledEventKey(context.generation) ==
+        context.eventKey) {
+        CHAN_TRACE("About to await a message in cancel because I was the one "
                    "fulfilled.  I'm on channel ",
                    &chanState);
-        const ChanProtocolMessage message = readMessage(ioEvent.file);
+        const bool failed =
+            awaitOutcome(*me.mailbox) == ChanProtocolMessage::ERROR;
         cleanup();
-        if (message == ChanProtocolMessage::ERROR) {
+        if (failed) {
             throw Error(ErrorCode::TRANSFER);
         }
     }
@@ -384,50 +570,45 @@ void ChanEvent<POLICY>::cancel(IoEvent ioEvent) {
     }
 }
 
-// This function-like object is meant to be used to find a `ChanSender` or a
-// `ChanReceiver` based on the value of its `Pipe*` member.
-class PipeEquals {
-    const Pipe* lookingFor;
-
-  public:
-    explicit PipeEquals(const Pipe* lookingFor)
-    : lookingFor(lookingFor) {
+// Poke the first of the specified `waiters` that isn't already poked, if any.
+// Return the wakeup to post for it after releasing the `ChanState`'s mutex, or
+// return null if there's nothing to post.  The `ChanState`'s mutex must be
+// locked.
+template <typename PARTICIPANT>
+ThreadWakeup* pokeFirstUnpoked(WaiterList<PARTICIPANT>& waiters) {
+    for (PARTICIPANT* it = waiters.first(); it; it = waiters.after(*it)) {
+        if (!it->isPoked) {
+            it->isPoked = true;
+            return sendMessage(*it->mailbox, ChanProtocolMessage::POKE)
+                       ? it->mailbox->wakeup
+                       : 0;
+        }
     }
 
-    bool operator()(const ChanParticipant& participant) const {
-        return participant.pipe == lookingFor;
-    }
-};
+    return 0;
+}
 
 template <typename POLICY>
 void ChanEvent<POLICY>::cleanup() {
     // Depending on the reference counts that we see after locking the mutex,
-    // we might afterward deallocate some pipe.  These flags keep track of
+    // we might afterward deallocate some mailbox.  These flags keep track of
     // whether to do so.
-    bool deallocateMyPipe    = false;
-    bool deallocateTheirPipe = false;
+    bool deallocateMyMailbox    = false;
+    bool deallocateTheirMailbox = false;
 
-    // To prevent memory deallocations from happening in the critical section
-    // below, this `list` is used as a placeholder into which the node we
-    // wish to remove from `teammates` can be spliced.
-    std::list<Teammate> removedNode;
+    // If we poke the next sitter, its thread is woken up after the mutex is
+    // released (see `sendMessage` in `chan/chanevents/chanprotocol.h`).
+    bool          wakeNextUp   = false;
+    ThreadWakeup* nextUpWakeup = 0;
 
     CHAN_TRACE("In cleanup(), about to acquire mutex for chanState ",
                &chanState);
 
     CHAN_WITH_LOCK(chanState.mutex) {
         CHAN_TRACE("In cleanup(), acquired mutex for chanState ", &chanState);
-        std::list<Teammate>& teammates = POLICY::teammates(chanState);
-
-        // Find our entry in `teammates`.  Checking the `Pipe*` suffices.
-        assert(!teammates.empty());
-
-        const typename std::list<Teammate>::iterator found = std::find_if(
-            teammates.begin(), teammates.end(), PipeEquals(me.pipe));
-
-        assert(found != teammates.end());
+        WaiterList<Teammate>& teammates = POLICY::teammates(chanState);
 
-        const bool weWereUpFront = found == teammates.begin();
+        const bool weWereUpFront = &teammates.front() == &me;
         if (weWereUpFront) {
             CHAN_TRACE("Removing myself from the front of ", &chanState);
         }
@@ -435,43 +616,194 @@ void ChanEvent<POLICY>::cleanup() {
             CHAN_TRACE("Removing myself from the not-front of ", &chanState);
         }
 
-        // Remove me from `teammates`.
-        removedNode.splice(removedNode.begin(), teammates, found);
+        // Remove me from `teammates`.  Whether I was poked matters below.
+        teammates.remove(me);
+        const bool wasPoked = me.isPoked;
+        me.isPoked          = false;
 
-        // Decrement reference count on visible `Pipe`s.
-        deallocateMyPipe = --me.pipe->referenceCount == 0;
-        CHAN_TRACE("Decremented my pipe ",
-                   me.pipe,
+        // Nobody can poke me now that I'm not in `teammates`.  If I was poked
+        // but didn't get around to handling it, take the `POKE` anyway, so
+        // that its wakeup doesn't linger on my thread.
+        takeMessage(*me.mailbox, ChanProtocolMessage::POKE);
+
+        // Decrement reference count on visible `Mailbox`es.
+        deallocateMyMailbox = --me.mailbox->referenceCount == 0;
+        CHAN_TRACE("Decremented my mailbox ",
+                   me.mailbox,
                    " down to ",
-                   me.pipe->referenceCount);
+                   me.mailbox->referenceCount);
 
-        if (them.pipe) {
-            deallocateTheirPipe = --them.pipe->referenceCount == 0;
-            CHAN_TRACE("Decremented their pipe ",
-                       them.pipe,
+        if (them.mailbox) {
+            deallocateTheirMailbox = --them.mailbox->referenceCount == 0;
+            CHAN_TRACE("Decremented their mailbox ",
+                       them.mailbox,
                        " down to ",
-                       them.pipe->referenceCount);
+                       them.mailbox->referenceCount);
         }
 
-        // If we need to poke the next sitter, do so.
-        std::list<Opponent>& opponents = POLICY::opponents(chanState);
-        if (weWereUpFront && !teammates.empty() && !opponents.empty()) {
+        // If we need to poke the next sitter, do so.  On a buffered channel,
+        // a poke means that the buffer became ready, so if we were poked,
+        // pass it on in case it still is.
+        WaiterList<Opponent>& opponents = POLICY::opponents(chanState);
+        if (POLICY::isBuffered(chanState)) {
+            if (wasPoked && POLICY::bufferReady(chanState)) {
+                nextUpWakeup = pokeFirstUnpoked(teammates);
+                wakeNextUp   = nextUpWakeup != 0;
+            }
+        }
+        else if (weWereUpFront && !teammates.empty() && !opponents.empty()) {
             // There was somebody behind us in `teammates` that could be
             // talking the the first of the `opponents`.  Poke the
             // teammate.
             Teammate& nextUp = teammates.front();
             nextUp.isPoked   = true;
-            writeMessage(nextUp.pipe->toSitter, ChanProtocolMessage::POKE);
+            wakeNextUp =
+                sendMessage(*nextUp.mailbox, ChanProtocolMessage::POKE);
+            nextUpWakeup = nextUp.mailbox->wakeup;
         }
     }
 
-    if (deallocateMyPipe) {
-        chanState.pipePool.deallocate(me.pipe);
+    if (wakeNextUp) {
+        postWakeup(*nextUpWakeup);
+    }
+
+    if (deallocateMyMailbox) {
+        chanState.mailboxPool.deallocate(me.mailbox);
+    }
+
+    if (deallocateTheirMailbox) {
+        chanState.mailboxPool.deallocate(them.mailbox);
+    }
+
+    // Forget about this `select` invocation, so that this event can be used
+    // again (e.g. by a `SelectSet`).
+    me.mailbox = 0;
+    me.context = EventContext();
+    them       = Opponent();
+}
+
+template <typename POLICY>
+bool ChanEvent<POLICY>::tryBuffer(ThreadWakeup** toWake) {
+    // My `select` has claimed its `SelectorFulfillment` while it calls me, so
+    // none of its events can have been fulfilled, and it will mark me
+    // fulfilled once I return.
+    if (!POLICY::bufferReady(chanState)) {
+        return false;
     }
 
-    if (deallocateTheirPipe) {
-        chanState.pipePool.deallocate(them.pipe);
+    // If this throws, then `chanState.buffer` hasn't changed.
+    POLICY::transferWithBuffer(chanState, me);
+
+    // The buffer is now ready for the other side (not full, or not empty).
+    // Each change pokes at most one waiter, who passes the poke on if it
+    // leaves without acting on it (see `cleanup`).
+    *toWake = pokeFirstUnpoked(POLICY::opponents(chanState));
+    return true;
+}
+
+template <typename POLICY>
+IoEvent ChanEvent<POLICY>::fileBuffered() {
+    // Usually the buffer is ready, in which case I needn't wait, and so
+    // needn't join `teammates` or have a mailbox.  Try that first.
+    ThreadWakeup* toWake = 0;
+    bool          done;
+    CHAN_WITH_LOCK(chanState.mutex) {
+        done = tryBuffer(&toWake);
     }
+
+    if (!done) {
+        // I'll have to wait, so allocate a mailbox, and then try again, since
+        // the buffer might have become ready meanwhile.
+        me.mailbox = chanState.mailboxPool.allocate();
+        try {
+            CHAN_WITH_LOCK(chanState.mutex) {
+                done = tryBuffer(&toWake);
+                if (!done) {
+                    CHAN_TRACE("Waiting on buffered channel ", &chanState);
+                    POLICY::teammates(chanState).push_back(me);
+                }
+            }
+        }
+        catch (...) {
+            --me.mailbox->referenceCount;
+            chanState.mailboxPool.deallocate(me.mailbox);
+            me.mailbox = 0;
+            throw;
+        }
+
+        if (done) {
+            --me.mailbox->referenceCount;
+            chanState.mailboxPool.deallocate(me.mailbox);
+            me.mailbox = 0;
+        }
+    }
+
+    if (toWake) {
+        postWakeup(*toWake);
+    }
+
+    IoEvent event;
+    if (done) {
+        // Forget about this `select` invocation, as `cleanup` does.
+        me.context      = EventContext();
+        event.fulfilled = true;
+        return event;
+    }
+
+    event.read         = true;
+    event.notification = true;
+    event.file         = me.mailbox->wakeup->waitFile;
+    return event;
+}
+
+template <typename POLICY>
+IoEvent ChanEvent<POLICY>::fulfillBuffered(IoEvent event) {
+    ThreadWakeup* toWake         = 0;
+    ThreadWakeup* teammateToWake = 0;
+    bool          done;
+    CHAN_WITH_LOCK(chanState.mutex) {
+        if (!takeMessage(*me.mailbox, ChanProtocolMessage::POKE)) {
+            // The wakeup was for some other event on my thread.
+            return event;
+        }
+
+        // Somebody changed the buffer, so it might now be ready for me.
+        assert(me.isLinked());
+        assert(me.isPoked);
+
+        // If `tryBuffer` throws, I'm still poked, and so `cleanup` will pass
+        // the poke on.
+        done = tryBuffer(&toWake);
+
+        // Whoever poked me might have made the buffer ready for more than
+        // just me, e.g. by sending several objects at once.  If it's still
+        // ready, pass the poke on to the next of us, who will do the same.
+        // I'm still poked, so it isn't me.
+        if (done && POLICY::bufferReady(chanState)) {
+            teammateToWake = pokeFirstUnpoked(POLICY::teammates(chanState));
+        }
+        me.isPoked = false;
+        CHAN_TRACE("Handled a POKE on buffered channel ",
+                   &chanState,
+                   done ? " and used the buffer" : " but must keep waiting");
+    }
+
+    if (toWake) {
+        postWakeup(*toWake);
+    }
+
+    if (teammateToWake) {
+        postWakeup(*teammateToWake);
+    }
+
+    if (!done) {
+        // Somebody else got to the buffer first.  Keep waiting.
+        return event;
+    }
+
+    cleanup();
+    event.fulfilled = true;
+    return event;
 }
 
 }  // namespace chan
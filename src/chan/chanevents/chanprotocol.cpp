@@ -1,10 +1,7 @@
 #include <chan/chanevents/chanprotocol.h>
+#include <chan/chanstate/mailbox.h>
 #include <chan/debug/trace.h>
-#include <chan/errors/error.h>
-#include <chan/errors/errorcode.h>
-
-#include <errno.h>
-#include <unistd.h>  // read, write
+#include <chan/files/threadwakeup.h>
 
 #include <cassert>
 
@@ -12,23 +9,18 @@ namespace chan {
 
 namespace {
 
-char toByte(ChanProtocolMessage message) {
-    return message;
-}
-
-ChanProtocolMessage fromByte(char byte) {
-    const ChanProtocolMessage result =
-        static_cast<ChanProtocolMessage::Value>(byte);
-
-    switch (result) {
+// Return the flag in the specified `mailbox` that indicates whether the
+// specified `message` is pending.
+bool& pending(Mailbox& mailbox, ChanProtocolMessage message) {
+    switch (message) {
         case ChanProtocolMessage::DONE:
+            return mailbox.pendingDone;
         case ChanProtocolMessage::ERROR:
-            break;
+            return mailbox.pendingError;
         default:
-            assert(result == ChanProtocolMessage::POKE);
+            assert(message == ChanProtocolMessage::POKE);
+            return mailbox.pendingPoke;
     }
-
-    return result;
 }
 
 // `toName` is only used in `CHAN_TRACE` messages (debugging).
@@ -50,55 +42,71 @@ const char* toName(ChanProtocolMessage message) {
 
 }  // namespace
 
-void writeMessage(int file, ChanProtocolMessage message) {
-    const char payload  = toByte(message);
-    const int  numBytes = sizeof(payload);
-
-    CHAN_TRACE("- writing ", toName(message), " to fd ", file);
+bool sendMessage(Mailbox& mailbox, ChanProtocolMessage message) {
+    bool& flag = pending(mailbox, message);
+    if (__atomic_load_n(&flag, __ATOMIC_RELAXED)) {
+        // The recipient hasn't taken the previous one yet.  It will take only
+        // one, so there must be only one wakeup.
+        CHAN_TRACE("- ", toName(message), " already pending in ", &mailbox);
+        return false;
+    }
 
-    for (;;) {
-        const int rc = ::write(file, &payload, numBytes);
-        if (rc == -1) {
-            const int error = errno;
-            if (error == EINTR) {
-                continue;
-            }
+    CHAN_TRACE("- sending ", toName(message), " to ", &mailbox);
 
-            throw Error(ErrorCode::PROTOCOL_WRITE, error);
-        }
+    // The release pairs with the acquire in `takeMessage`, so that the
+    // recipient of `DONE` sees the transferred object.
+    __atomic_store_n(&flag, true, __ATOMIC_RELEASE);
+    return true;
+}
 
-        // For an in-depth exploration of whether `write` can return zero when
-        // a nonzero number of bytes was specified, see:
-        // https://stackoverflow.com/questions/41904221/
-        //          can-write2-return-0-bytes-written-and-what-to-do-if-it-does
-        // I'm comfortable assuming that it won't.
-        assert(rc == numBytes);
-        return;
+bool takeMessage(Mailbox& mailbox, ChanProtocolMessage message) {
+    bool& flag = pending(mailbox, message);
+    if (!__atomic_load_n(&flag, __ATOMIC_ACQUIRE)) {
+        return false;
     }
-}
 
-ChanProtocolMessage readMessage(int file) {
-    char      byte;
-    const int numBytes = sizeof(byte);
+    CHAN_TRACE("- taking ", toName(message), " from ", &mailbox);
+
+    consumeWakeup(*mailbox.wakeup);
+    __atomic_store_n(&flag, false, __ATOMIC_RELAXED);
+    return true;
+}
 
+ChanProtocolMessage awaitOutcome(Mailbox& mailbox) {
+    // The visitor sends its message after the transfer, which happens after
+    // it fulfilled us, so the message might not be here yet.  In that case,
+    // wait for wakeups until it is.  Those consumed meanwhile might belong to
+    // other messages, e.g. a `POKE` for another event in the same `select`,
+    // so one of them stands in for ours, and the rest are posted again.
+    int numBorrowed = 0;
     for (;;) {
-        const int rc = ::read(file, &byte, numBytes);
-        if (rc == -1) {
-            const int error = errno;
-            if (error == EINTR) {
-                continue;
+        ChanProtocolMessage message = ChanProtocolMessage::ERROR;
+        bool*               flag    = &pending(mailbox, message);
+        if (!__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+            message = ChanProtocolMessage::DONE;
+            flag    = &pending(mailbox, message);
+        }
+
+        if (__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+            CHAN_TRACE("- taking ", toName(message), " from ", &mailbox);
+
+            if (numBorrowed) {
+                --numBorrowed;
+            }
+            else {
+                consumeWakeup(*mailbox.wakeup);
             }
+            __atomic_store_n(flag, false, __ATOMIC_RELAXED);
 
-            throw Error(ErrorCode::PROTOCOL_READ, error);
-        }
-        else if (rc == 0) {
-            throw Error(ErrorCode::PROTOCOL_READ_EOF);
+            for (; numBorrowed; --numBorrowed) {
+                postWakeup(*mailbox.wakeup);
+            }
+            return message;
         }
 
-        assert(rc == numBytes);
-
-        CHAN_TRACE("- reading ", toName(fromByte(byte)), " from fd ", file);
-        return fromByte(byte);
+        CHAN_TRACE("- awaiting DONE or ERROR in ", &mailbox);
+        consumeWakeup(*mailbox.wakeup);
+        ++numBorrowed;
     }
 }
 
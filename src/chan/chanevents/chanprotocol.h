@@ -3,6 +3,8 @@
 
 namespace chan {
 
+struct Mailbox;
+
 class ChanProtocolMessage {
   public:
     enum Value {
@@ -24,13 +26,35 @@ class ChanProtocolMessage {
     }
 };
 
-// Write the specified `message` to the specified `file`.  If an error occurs,
-// throw an exception.
-void writeMessage(int file, ChanProtocolMessage message);
-
-// Return a `ChanProtocolMessage` read from the specified `file`.  If an error
-// occurs, throw an exception.
-ChanProtocolMessage readMessage(int file);
+// Record the specified `message` as pending in the specified `mailbox`.
+// Return `true` if the recipient must now be woken up, or `false` if the
+// message was already pending.  For `POKE`, the caller must hold the
+// `ChanState`'s mutex.  For `DONE` and `ERROR`, the caller must be the visitor
+// that fulfilled the recipient's event (see
+// `chan/chanevents/fulfillmentclaim.h`), which sends one or the other once
+// it's done transferring, and the recipient waits for it using
+// `awaitOutcome`.
+//
+// If this function returns `true`, the caller must then call `postWakeup`
+// (see `chan/files/threadwakeup.h`) on `*mailbox.wakeup`, with the pointer
+// read while holding that lock or claim, and should do so after giving it up,
+// so that the recipient doesn't wake up only to wait for it.  This is safe
+// because the recipient can't finish taking the message until the wakeup
+// arrives.
+bool sendMessage(Mailbox& mailbox, ChanProtocolMessage message);
+
+// If the specified `message` is pending in the specified `mailbox`, then
+// take it, consuming (waiting for, if necessary) the wakeup that accompanies
+// it, and return `true`.
+// Otherwise, return `false`.  If an error occurs, throw an exception.  For
+// `POKE`, the caller must hold the `ChanState`'s mutex.
+bool takeMessage(Mailbox& mailbox, ChanProtocolMessage message);
+
+// Wait until `DONE` or `ERROR` is pending in the specified `mailbox`, take it
+// as `takeMessage` does, and return which it was.  The behavior is undefined
+// unless a visitor fulfilled the event to which `mailbox` belongs.  If an
+// error occurs, throw an exception.
+ChanProtocolMessage awaitOutcome(Mailbox& mailbox);
 
 }  // namespace chan
 
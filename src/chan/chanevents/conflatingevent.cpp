@@ -0,0 +1 @@
+#include <chan/chanevents/conflatingevent.h>
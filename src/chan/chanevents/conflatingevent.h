@@ -0,0 +1,151 @@
+#ifndef INCLUDED_CHAN_CHANEVENTS_CONFLATINGEVENT
+#define INCLUDED_CHAN_CHANEVENTS_CONFLATINGEVENT
+
+// This component provides the events of `ConflatingChan` (see
+// `chan/chan/conflatingchan.h`): `ConflatingSendEvent` and
+// `ConflatingRecvEvent`.  They're `ChanEvent`s, like `SendEvent` and
+// `RecvEvent`, whose policies treat the channel as always buffered, with a
+// `ConflatingBuffer` that's never full.  So a send is fulfilled as soon as it
+// is selected upon, and a receive once some value is pending.
+
+#include <chan/chanevents/chanevent.h>
+#include <chan/chanevents/recvevent.h>
+#include <chan/chanevents/sendevent.h>
+#include <chan/chanstate/chanstate.h>
+#include <chan/chanstate/conflatingbuffer.h>
+#include <chan/chanstate/conflatingstate.h>
+#include <chan/chanstate/optional.h>
+#include <chan/chanstate/waiterlist.h>
+
+#include <cassert>
+
+namespace chan {
+
+// Senders transfer into the buffer, overwriting the pending value that has
+// the same key, if any, and receivers transfer out of it, one value at a
+// time.
+template <typename OBJECT, typename KEY>
+void transfer(const ChanSender<OBJECT>&      sender,
+              ConflatingBuffer<OBJECT, KEY>& buffer) {
+    assert(sender.count == 1);
+
+    if (sender.transferMode == ChanSender<OBJECT>::MOVE) {
+        assert(sender.moveFrom);
+        buffer.putMove(*sender.moveFrom);
+    }
+    else {
+        assert(sender.transferMode == ChanSender<OBJECT>::COPY);
+        assert(sender.copyFrom);
+        buffer.putCopy(*sender.copyFrom);
+    }
+
+    recordTransfer(sender, 1);
+}
+
+template <typename OBJECT, typename KEY>
+void transfer(ConflatingBuffer<OBJECT, KEY>& buffer,
+              const ChanReceiver<OBJECT>&    receiver) {
+    assert(receiver.count == 1);
+
+    if (receiver.transferMode == ChanReceiver<OBJECT>::CONSTRUCT) {
+        buffer.pop(receiver.slot);
+    }
+    else {
+        assert(receiver.transferMode == ChanReceiver<OBJECT>::ASSIGN);
+        buffer.pop(receiver.destination);
+    }
+
+    recordTransfer(receiver, 1);
+}
+
+template <typename OBJECT, typename KEY>
+struct ConflatingSendEventPolicy {
+    typedef ConflatingState<OBJECT, KEY> State;
+    typedef ChanSender<OBJECT>           Teammate;
+    typedef ChanReceiver<OBJECT>         Opponent;
+
+    static WaiterList<Teammate>& teammates(State& state) {
+        return state.senders;
+    }
+
+    static WaiterList<Opponent>& opponents(State& state) {
+        return state.receivers;
+    }
+
+    static bool isBuffered(const State&) {
+        return true;
+    }
+
+    // A sender never waits.
+    static bool bufferReady(const State&) {
+        return true;
+    }
+
+    static void transferWithBuffer(State& state, const Teammate& me) {
+        transfer(me, state.buffer);
+    }
+};
+
+template <typename OBJECT, typename KEY>
+struct ConflatingRecvEventPolicy {
+    typedef ConflatingState<OBJECT, KEY> State;
+    typedef ChanReceiver<OBJECT>         Teammate;
+    typedef ChanSender<OBJECT>           Opponent;
+
+    static WaiterList<Teammate>& teammates(State& state) {
+        return state.receivers;
+    }
+
+    static WaiterList<Opponent>& opponents(State& state) {
+        return state.senders;
+    }
+
+    static bool isBuffered(const State&) {
+        return true;
+    }
+
+    static bool bufferReady(const State& state) {
+        return !state.buffer.empty();
+    }
+
+    static void transferWithBuffer(State& state, const Teammate& me) {
+        transfer(state.buffer, me);
+    }
+};
+
+template <typename OBJECT, typename KEY>
+class ConflatingSendEvent
+: public ChanEvent<ConflatingSendEventPolicy<OBJECT, KEY> > {
+    typedef ChanEvent<ConflatingSendEventPolicy<OBJECT, KEY> > Base;
+
+  public:
+    ConflatingSendEvent(ConflatingState<OBJECT, KEY>& state, OBJECT* source)
+    : Base(state, makeSender(source)) {
+    }
+
+    ConflatingSendEvent(ConflatingState<OBJECT, KEY>& state,
+                        const OBJECT*                 source)
+    : Base(state, makeSender(source)) {
+    }
+};
+
+template <typename OBJECT, typename KEY>
+class ConflatingRecvEvent
+: public ChanEvent<ConflatingRecvEventPolicy<OBJECT, KEY> > {
+    typedef ChanEvent<ConflatingRecvEventPolicy<OBJECT, KEY> > Base;
+
+  public:
+    ConflatingRecvEvent(ConflatingState<OBJECT, KEY>& state,
+                        OBJECT*                       destination)
+    : Base(state, makeReceiver(destination)) {
+    }
+
+    ConflatingRecvEvent(ConflatingState<OBJECT, KEY>& state,
+                        Optional<OBJECT>*             slot)
+    : Base(state, makeReceiver(slot)) {
+    }
+};
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,43 @@
+#include <chan/chanevents/fulfillmentclaim.h>
+
+namespace chan {
+
+FulfillmentClaim::FulfillmentClaim(const EventContext& mine,
+                                   const EventContext& theirs)
+: mine(mine)
+, theirs(theirs)
+, haveMine(true)
+, haveTheirs(false) {
+    SelectorFulfillment& myFulfillment    = *mine.fulfillment;
+    SelectorFulfillment& theirFulfillment = *theirs.fulfillment;
+    if (&myFulfillment == &theirFulfillment) {
+        return;  // a `select` can't visit itself
+    }
+
+    // Usually nobody else has a claim on theirs, in which case the order
+    // doesn't matter, since we don't wait.
+    const int state = theirFulfillment.tryClaim(theirs.generation);
+    if (state == SelectorFulfillment::FULFILLABLE) {
+        haveTheirs = true;
+    }
+    else if (state != SelectorFulfillment::CLAIMED) {
+        // Theirs is fulfilled or unfulfillable, and will stay that way.
+    }
+    else if (&myFulfillment < &theirFulfillment) {
+        // Mine is already claimed, so I can just wait to claim theirs.
+        haveTheirs = theirFulfillment.claim(theirs.generation);
+    }
+    else {
+        // In order to claim mine _after_ claiming theirs, I must first release
+        // mine.
+        myFulfillment.release();
+        haveTheirs = theirFulfillment.claim(theirs.generation);
+        haveMine   = myFulfillment.claim(mine.generation);
+        if (!haveMine && haveTheirs) {
+            theirFulfillment.release();
+            haveTheirs = false;
+        }
+    }
+}
+
+}  // namespace chan
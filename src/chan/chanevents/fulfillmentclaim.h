@@ -0,0 +1,83 @@
+#ifndef INCLUDED_CHAN_CHANEVENTS_FULFILLMENTCLAIM
+#define INCLUDED_CHAN_CHANEVENTS_FULFILLMENTCLAIM
+
+#include <chan/event/eventcontext.h>
+
+#include <cassert>
+
+namespace chan {
+
+// When a visitor `ChanEvent` is interested in initiating a transfer with a
+// sitter `ChanEvent`, it must first claim the sitter's `SelectorFulfillment`
+// (see `chan/event/eventcontext.h`) in addition to its own.  The visitor's
+// own will already be claimed when the event is called by `select`, so
+// usually the sitter's can be claimed right away.  If somebody else has a
+// claim on the sitter's, though, then the visitor must wait, and in order to
+// avoid two visitors waiting for each other, the two claims must be acquired
+// in the same order.  This order is determined by the memory addresses of the
+// `SelectorFulfillment`s.  If the sitter's is ordered _before_ the visitor's,
+// then the visitor must first release its own, and claim it again after the
+// sitter's.  Meanwhile, an event in some other `select` might fulfill the
+// visitor's.
+//
+// A `FulfillmentClaim` acquires the claims when it's created, and releases
+// the claim on the sitter's `SelectorFulfillment`, if it still has it, when
+// it's destroyed.  The claim on the visitor's own belongs to `select`, unless
+// the visitor fulfills both with `fulfillBoth`, which it does before it
+// transfers an object, so that nobody waits for the transfer in order to
+// claim either one.  Its `select` then finds the visitor already fulfilled.
+class FulfillmentClaim {
+    EventContext mine;
+    EventContext theirs;
+    bool         haveMine;
+    bool         haveTheirs;
+
+    FulfillmentClaim(const FulfillmentClaim&) /* = delete */;
+    FulfillmentClaim& operator=(const FulfillmentClaim&) /* = delete */;
+
+  public:
+    // Claim the `SelectorFulfillment` of the specified `theirs`, and make
+    // sure that that of the specified `mine` is claimed, if each is still
+    // fulfillable.  The behavior is undefined unless the caller has a claim on
+    // `mine`'s.  If `mine` and `theirs` have the same `SelectorFulfillment`,
+    // then either the visitor and the sitter are in the same `select`, which
+    // can't fulfill both, or the sitter's `select` is over, so `theirs` is
+    // not claimed.
+    FulfillmentClaim(const EventContext& mine, const EventContext& theirs);
+
+    ~FulfillmentClaim() {
+        if (haveTheirs) {
+            theirs.fulfillment->release();
+        }
+    }
+
+    // Return whether the caller still has a claim on `mine`.  If not, then
+    // some other `select` fulfilled one of the visitor's events.
+    bool mineIsClaimed() const {
+        return haveMine;
+    }
+
+    // Return whether this object has a claim on `theirs`.  If not, then one
+    // of the sitter's events was fulfilled, or the sitter's `select` is
+    // handling an error.
+    bool theirsIsClaimed() const {
+        return haveTheirs;
+    }
+
+    // Mark the visitor's event and the sitter's event, having the `eventKey`
+    // of `mine` and of `theirs`, respectively, as fulfilled, giving up both
+    // claims.  The behavior is undefined unless `mineIsClaimed()` and
+    // `theirsIsClaimed()`.
+    void fulfillBoth() {
+        assert(haveMine);
+        assert(haveTheirs);
+        haveMine   = false;
+        haveTheirs = false;
+        theirs.fulfillment->fulfill(theirs.eventKey);
+        mine.fulfillment->fulfill(mine.eventKey);
+    }
+};
+
+}  // namespace chan
+
+#endif
@@ -1 +0,0 @@
-#include <chan/chanevents/fulfillmentlockguard.h>
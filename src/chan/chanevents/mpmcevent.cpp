@@ -0,0 +1 @@
+#include <chan/chanevents/mpmcevent.h>
@@ -0,0 +1,313 @@
+#ifndef INCLUDED_CHAN_CHANEVENTS_MPMCEVENT
+#define INCLUDED_CHAN_CHANEVENTS_MPMCEVENT
+
+// This component provides the events of `MpmcChan` (see
+// `chan/chan/mpmcchan.h`): `MpmcSendEvent` and `MpmcRecvEvent`.  They share
+// their logic in the class template `MpmcEvent`, whose `POLICY` says which
+// side of the `MpmcState` it's on.
+//
+// An `MpmcEvent` first tries to push onto or pop from the ring, which doesn't
+// lock anything.  Only if the ring is full or empty, respectively, does it
+// park a waiter in the `MpmcState`, and wait on its thread's `ThreadWakeup`
+// for a poke, after which it tries again.
+//
+// A push or pop is never undone, and doesn't involve any other `select`, so
+// an `MpmcEvent` doesn't need its `EventContext`.
+
+#include <chan/chanstate/mpmcstate.h>
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/errors/noexcept.h>
+#include <chan/errors/uncaughtexceptions.h>
+#include <chan/event/eventcontext.h>
+#include <chan/event/ioevent.h>
+#include <chan/files/threadwakeup.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/select.h>
+#include <chan/select/selectone.h>
+
+#include <cassert>
+#include <exception>
+#include <list>
+
+namespace chan {
+
+template <typename OBJECT>
+struct MpmcSender {
+    // Exactly one of these is set.  In C++98, "move" means swap.
+    OBJECT*       moveFrom;
+    const OBJECT* copyFrom;
+};
+
+template <typename OBJECT>
+struct MpmcReceiver {
+    OBJECT* destination;
+};
+
+template <typename OBJECT>
+struct MpmcSendEventPolicy {
+    typedef MpmcState<OBJECT>  State;
+    typedef MpmcSender<OBJECT> Endpoint;
+
+    static typename State::Side mySide() {
+        return State::SENDER;
+    }
+
+    static typename State::Side theirSide() {
+        return State::RECEIVER;
+    }
+
+    static bool transfer(State& state, const Endpoint& me) {
+        return me.moveFrom ? state.tryPushMove(*me.moveFrom)
+                           : state.tryPushCopy(*me.copyFrom);
+    }
+};
+
+template <typename OBJECT>
+struct MpmcRecvEventPolicy {
+    typedef MpmcState<OBJECT>    State;
+    typedef MpmcReceiver<OBJECT> Endpoint;
+
+    static typename State::Side mySide() {
+        return State::RECEIVER;
+    }
+
+    static typename State::Side theirSide() {
+        return State::SENDER;
+    }
+
+    static bool transfer(State& state, const Endpoint& me) {
+        return state.tryPop(me.destination);
+    }
+};
+
+template <typename POLICY>
+class MpmcEvent {
+  public:
+    typedef typename POLICY::State    State;
+    typedef typename POLICY::Endpoint Endpoint;
+
+  private:
+    typedef std::list<MpmcWaiter> Waiters;
+
+    Endpoint          me;
+    State&            state;
+    Waiters::iterator waiter;    // my node in `state`, while parked
+    bool              isParked;
+    mutable bool      selectOnDestroy;
+
+  public:
+    MpmcEvent(State& state, const Endpoint& me);
+    MpmcEvent(const MpmcEvent& other);
+    ~MpmcEvent() CHAN_THROWS;
+
+    void    touch() CHAN_NOEXCEPT;
+    IoEvent file(const EventContext&);
+    IoEvent fulfill(IoEvent);
+    void    cancel(IoEvent);
+
+  private:
+    // Transfer between me and the ring, and if that succeeds, poke somebody
+    // on the other side if anybody is parked, and return `true`.  Otherwise,
+    // return `false`.
+    bool attempt();
+
+    // Park a waiter for my thread, and then attempt the transfer once more,
+    // since the ring might have changed before I was parked.  Return the
+    // `IoEvent` to wait on, or a fulfilled one.
+    IoEvent park();
+
+    // Remove my waiter if it's parked, passing on any poke it didn't use.
+    void unpark();
+};
+
+template <typename POLICY>
+MpmcEvent<POLICY>::MpmcEvent(State& state, const Endpoint& me)
+: me(me)
+, state(state)
+, waiter()
+, isParked(false)
+, selectOnDestroy(true) {
+}
+
+template <typename POLICY>
+MpmcEvent<POLICY>::MpmcEvent(const MpmcEvent& other)
+: me(other.me)
+, state(other.state)
+, waiter()
+, isParked(false)
+, selectOnDestroy(other.selectOnDestroy) {
+    assert(!other.isParked);
+    other.selectOnDestroy = false;
+}
+
+template <typename POLICY>
+MpmcEvent<POLICY>::~MpmcEvent() CHAN_THROWS {
+    if (!selectOnDestroy || uncaughtExceptions()) {
+        return;
+    }
+
+    // Usually the ring is ready, in which case there's no need for `select`.
+    // If the transfer throws, report it as `select` would have.
+    bool done;
+    try {
+        done = attempt();
+    }
+    catch (const Error&) {
+        throw;
+    }
+    catch (const std::exception& error) {
+        throw Error(error.what());
+    }
+    catch (...) {
+        throw Error(ErrorCode::OTHER);
+    }
+
+    if (!done && selectOne(EventRef(*this))) {
+        throw lastError();
+    }
+}
+
+template <typename POLICY>
+void MpmcEvent<POLICY>::touch() CHAN_NOEXCEPT {
+    // I'm being called by `select`, so there's no need to call `select` in my
+    // destructor.
+    selectOnDestroy = false;
+}
+
+template <typename POLICY>
+IoEvent MpmcEvent<POLICY>::file(const EventContext&) {
+    if (attempt()) {
+        IoEvent event;
+        event.fulfilled = true;
+        return event;
+    }
+
+    return park();
+}
+
+template <typename POLICY>
+IoEvent MpmcEvent<POLICY>::fulfill(IoEvent event) {
+    assert(isParked);
+    assert(event.read);
+    assert(event.file == waiter->wakeup->waitFile);
+
+    if (!state.takePoke(POLICY::mySide(), waiter)) {
+        // The wakeup was for some other event on my thread.  Keep waiting.
+        return event;
+    }
+
+    // The ring might be ready now, unless somebody else got to it first, in
+    // which case I remain parked, and will be poked again.
+    if (!attempt()) {
+        return event;
+    }
+
+    unpark();
+    event.fulfilled = true;
+    return event;
+}
+
+template <typename POLICY>
+void MpmcEvent<POLICY>::cancel(IoEvent) {
+    unpark();
+}
+
+template <typename POLICY>
+bool MpmcEvent<POLICY>::attempt() {
+    if (!POLICY::transfer(state, me)) {
+        return false;
+    }
+
+    state.wake(POLICY::theirSide());
+    return true;
+}
+
+template <typename POLICY>
+IoEvent MpmcEvent<POLICY>::park() {
+    assert(!isParked);
+
+    // Allocate the node before locking anything.
+    const MpmcWaiter node = { &threadWakeup(), false };
+    Waiters          oneNode(1, node);
+    waiter = oneNode.begin();
+
+    state.park(POLICY::mySide(), oneNode);
+    isParked = true;
+
+    bool done;
+    try {
+        done = attempt();
+    }
+    catch (...) {
+        unpark();
+        throw;
+    }
+
+    IoEvent event;
+    if (done) {
+        unpark();
+        event.fulfilled = true;
+        return event;
+    }
+
+    event.read         = true;
+    event.notification = true;
+    event.file         = waiter->wakeup->waitFile;
+    return event;
+}
+
+template <typename POLICY>
+void MpmcEvent<POLICY>::unpark() {
+    if (!isParked) {
+        return;
+    }
+
+    // The node is freed when `removed` is destroyed, after `state`'s mutex
+    // is released.
+    Waiters removed;
+    isParked = false;
+    state.unpark(POLICY::mySide(), waiter, removed);
+}
+
+template <typename OBJECT>
+class MpmcSendEvent : public MpmcEvent<MpmcSendEventPolicy<OBJECT> > {
+    typedef MpmcEvent<MpmcSendEventPolicy<OBJECT> > Base;
+
+    static MpmcSender<OBJECT> makeSender(OBJECT* moveFrom,
+                                         const OBJECT* copyFrom) {
+        const MpmcSender<OBJECT> sender = { moveFrom, copyFrom };
+        return sender;
+    }
+
+  public:
+    MpmcSendEvent(MpmcState<OBJECT>& state, OBJECT* source)
+    : Base(state, makeSender(source, 0)) {
+        assert(source);
+    }
+
+    MpmcSendEvent(MpmcState<OBJECT>& state, const OBJECT* source)
+    : Base(state, makeSender(0, source)) {
+        assert(source);
+    }
+};
+
+template <typename OBJECT>
+class MpmcRecvEvent : public MpmcEvent<MpmcRecvEventPolicy<OBJECT> > {
+    typedef MpmcEvent<MpmcRecvEventPolicy<OBJECT> > Base;
+
+    static MpmcReceiver<OBJECT> makeReceiver(OBJECT* destination) {
+        const MpmcReceiver<OBJECT> receiver = { destination };
+        return receiver;
+    }
+
+  public:
+    MpmcRecvEvent(MpmcState<OBJECT>& state, OBJECT* destination)
+    : Base(state, makeReceiver(destination)) {
+        assert(destination);
+    }
+};
+
+}  // namespace chan
+
+#endif
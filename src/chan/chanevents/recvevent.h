@@ -3,8 +3,13 @@
 
 #include <chan/chanevents/chanevent.h>
 #include <chan/chanstate/chanstate.h>
+#include <chan/chanstate/optional.h>
+#include <chan/chanstate/waiterlist.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/select.h>
 
-#include <list>
+#include <cassert>
+#include <cstddef>  // std::size_t
 
 namespace chan {
 
@@ -20,14 +25,29 @@ struct RecvEventPolicy {
     typedef ChanSender<OBJECT>   Opponent;
 
     // If you're a receiver, then your "teammates" are receivers.
-    static std::list<Teammate>& teammates(State& state) {
+    static WaiterList<Teammate>& teammates(State& state) {
         return state.receivers;
     }
 
     // If you're a receiver, then your "opponents" are senders.
-    static std::list<Opponent>& opponents(State& state) {
+    static WaiterList<Opponent>& opponents(State& state) {
         return state.senders;
     }
+
+    // A channel with a nonzero capacity is buffered.
+    static bool isBuffered(const State& state) {
+        return state.buffer.capacity() != 0;
+    }
+
+    // If you're a receiver on a buffered channel, then you can proceed when
+    // the buffer isn't empty, and you pop from it.
+    static bool bufferReady(const State& state) {
+        return !state.buffer.empty();
+    }
+
+    static void transferWithBuffer(State& state, const Teammate& me) {
+        transfer(state.buffer, me);
+    }
 };
 
 template <typename OBJECT>
@@ -35,13 +55,47 @@ class RecvEvent : public ChanEvent<RecvEventPolicy<OBJECT> > {
     typedef ChanEvent<RecvEventPolicy<OBJECT> > Base;
 
   public:
+    // Create an event that receives by assigning to the specified
+    // `destination`, or by constructing into the specified `slot`, which
+    // needn't contain an object already.
     RecvEvent(ChanState<OBJECT>& chanState, OBJECT* destination);
+    RecvEvent(ChanState<OBJECT>& chanState, Optional<OBJECT>* slot);
+};
+
+// A `RecvUpToEvent` receives up to a specified number of objects in one
+// rendezvous: as many as the sender it meets sends, or, on a buffered channel,
+// as many as are in the buffer.  At least one is received.  It's a
+// `RecvEvent` in every other way.  The number received is stored into a
+// specified `std::size_t`, or, if the event is converted to `std::size_t`,
+// returned.
+template <typename OBJECT>
+class RecvUpToEvent : public ChanEvent<RecvEventPolicy<OBJECT> > {
+    typedef ChanEvent<RecvEventPolicy<OBJECT> > Base;
+
+  public:
+    RecvUpToEvent(ChanState<OBJECT>& chanState,
+                  OBJECT*            destination,
+                  std::size_t        maxCount,
+                  std::size_t*       numReceived);
+
+    operator std::size_t() const;
 };
 
 template <typename OBJECT>
 ChanReceiver<OBJECT> makeReceiver(OBJECT* destination) {
     ChanReceiver<OBJECT> receiver;
-    receiver.destination = destination;
+    receiver.transferMode = ChanReceiver<OBJECT>::ASSIGN;
+    receiver.destination  = destination;
+    return receiver;
+}
+
+template <typename OBJECT>
+ChanReceiver<OBJECT> makeReceiver(Optional<OBJECT>* slot) {
+    assert(slot);
+
+    ChanReceiver<OBJECT> receiver;
+    receiver.transferMode = ChanReceiver<OBJECT>::CONSTRUCT;
+    receiver.slot         = slot;
     return receiver;
 }
 
@@ -50,6 +104,46 @@ RecvEvent<OBJECT>::RecvEvent(ChanState<OBJECT>& chanState, OBJECT* destination)
 : Base(chanState, makeReceiver(destination)) {
 }
 
+template <typename OBJECT>
+RecvEvent<OBJECT>::RecvEvent(ChanState<OBJECT>& chanState,
+                             Optional<OBJECT>*  slot)
+: Base(chanState, makeReceiver(slot)) {
+}
+
+template <typename OBJECT>
+ChanReceiver<OBJECT> makeReceiver(OBJECT*      destination,
+                                  std::size_t  maxCount,
+                                  std::size_t* numReceived) {
+    assert(maxCount);
+
+    ChanReceiver<OBJECT> receiver = makeReceiver(destination);
+    receiver.count                = maxCount;
+    receiver.numTransferred       = numReceived;
+    return receiver;
+}
+
+template <typename OBJECT>
+RecvUpToEvent<OBJECT>::RecvUpToEvent(ChanState<OBJECT>& chanState,
+                                     OBJECT*            destination,
+                                     std::size_t        maxCount,
+                                     std::size_t*       numReceived)
+: Base(chanState, makeReceiver(destination, maxCount, numReceived)) {
+}
+
+template <typename OBJECT>
+RecvUpToEvent<OBJECT>::operator std::size_t() const {
+    std::size_t numReceived;
+    this->me.numTransferred = &numReceived;
+
+    // `select` operates on a copy of this event, which relieves this one of
+    // selecting upon itself when it's destroyed.
+    if (select(*this)) {
+        throw lastError();
+    }
+
+    return numReceived;
+}
+
 }  // namespace chan
 
 #endif
@@ -3,8 +3,18 @@
 
 #include <chan/chanevents/chanevent.h>
 #include <chan/chanstate/chanstate.h>
-
-#include <list>
+#include <chan/chanstate/waiterlist.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/select.h>
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+#if __cplusplus >= 201402
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // std::forward, std::index_sequence
+#endif
 
 namespace chan {
 
@@ -20,14 +30,29 @@ struct SendEventPolicy {
     typedef ChanReceiver<OBJECT> Opponent;
 
     // If you're a sender, then your "teammates" are senders.
-    static std::list<Teammate>& teammates(State& state) {
+    static WaiterList<Teammate>& teammates(State& state) {
         return state.senders;
     }
 
     // If you're a sender, then your "opponents" are receivers.
-    static std::list<Opponent>& opponents(State& state) {
+    static WaiterList<Opponent>& opponents(State& state) {
         return state.receivers;
     }
+
+    // A channel with a nonzero capacity is buffered.
+    static bool isBuffered(const State& state) {
+        return state.buffer.capacity() != 0;
+    }
+
+    // If you're a sender on a buffered channel, then you can proceed when the
+    // buffer has room, and you push onto it.
+    static bool bufferReady(const State& state) {
+        return !state.buffer.full();
+    }
+
+    static void transferWithBuffer(State& state, const Teammate& me) {
+        transfer(me, state.buffer);
+    }
 };
 
 template <typename OBJECT>
@@ -39,6 +64,89 @@ class SendEvent : public ChanEvent<SendEventPolicy<OBJECT> > {
     SendEvent(ChanState<OBJECT>& chanState, const OBJECT* source);
 };
 
+// A `SendManyEvent` sends some of the objects in a range in one rendezvous: as
+// many as the receiver it meets has room for, or, on a buffered channel, as
+// many as fit in the buffer.  At least one is sent.  It's a `SendEvent` in
+// every other way.  The number sent is stored into a specified `std::size_t`,
+// or, if the event is converted to `std::size_t`, returned.
+template <typename OBJECT>
+class SendManyEvent : public ChanEvent<SendEventPolicy<OBJECT> > {
+    typedef ChanEvent<SendEventPolicy<OBJECT> > Base;
+
+  public:
+    SendManyEvent(ChanState<OBJECT>& chanState,
+                  OBJECT*            first,
+                  OBJECT*            last,
+                  std::size_t*       numSent);
+    SendManyEvent(ChanState<OBJECT>& chanState,
+                  const OBJECT*      first,
+                  const OBJECT*      last,
+                  std::size_t*       numSent);
+
+    operator std::size_t() const;
+};
+
+#if __cplusplus >= 201402
+// An `EmplaceEvent` sends an object that it constructs from the specified
+// arguments only once it knows where the object is going: into the slot of a
+// receiver's `Optional`, into the buffer, or, if the receiver assigns to an
+// existing object, into a temporary that's then moved there.  The arguments
+// are held by reference, so an `EmplaceEvent` mustn't outlive the full
+// expression that creates it.  It's a `SendEvent` in every other way.
+template <typename OBJECT, typename... ARGS>
+class EmplaceEvent : public ChanEvent<SendEventPolicy<OBJECT> > {
+    typedef ChanEvent<SendEventPolicy<OBJECT> > Base;
+
+    // Each argument is referred to as an lvalue, so that the event can be
+    // copied, and is forwarded as its `ARGS` says when the object is
+    // constructed.
+    typedef std::tuple<typename std::remove_reference<ARGS>::type&...>
+        Arguments;
+
+    Arguments arguments;
+
+    EmplaceEvent& operator=(const EmplaceEvent&) /* = delete */;
+
+    template <std::size_t... INDICES>
+    static void construct(void*            storage,
+                          const Arguments& arguments,
+                          std::index_sequence<INDICES...>) {
+        new (storage)
+            OBJECT(std::forward<ARGS>(std::get<INDICES>(arguments))...);
+    }
+
+    // This is the `ChanEmplacer::construct` of the sender.
+    static void construct(void* storage, const void* arguments) {
+        construct(storage,
+                  *static_cast<const Arguments*>(arguments),
+                  std::index_sequence_for<ARGS...>());
+    }
+
+    static ChanSender<OBJECT> makeSender() {
+        ChanSender<OBJECT> sender;
+        sender.transferMode       = ChanSender<OBJECT>::EMPLACE;
+        sender.emplacer.construct = &EmplaceEvent::construct;
+        sender.emplacer.arguments = 0;  // set once `arguments` exists
+        return sender;
+    }
+
+  public:
+    EmplaceEvent(ChanState<OBJECT>& chanState, ARGS&&... args)
+    : Base(chanState, makeSender())
+    , arguments(args...) {
+        this->me.emplacer.arguments = &arguments;
+    }
+
+    // `select` copies its events, and the copy's sender must refer to the
+    // copy's arguments.
+    EmplaceEvent(const EmplaceEvent& other)
+    : Base(other)
+    , arguments(other.arguments) {
+        this->me.emplacer.arguments = &arguments;
+    }
+};
+#endif
+
 template <typename OBJECT>
 ChanSender<OBJECT> makeSender(OBJECT* source) {
     ChanSender<OBJECT> sender;
@@ -70,6 +178,60 @@ SendEvent<OBJECT>::SendEvent(ChanState<OBJECT>& chanState,
 : Base(chanState, makeSender(source)) {
 }
 
+template <typename OBJECT>
+ChanSender<OBJECT> makeSender(OBJECT*      first,
+                              OBJECT*      last,
+                              std::size_t* numSent) {
+    assert(first < last);
+
+    ChanSender<OBJECT> sender = makeSender(first);
+    sender.count              = last - first;
+    sender.numTransferred     = numSent;
+    return sender;
+}
+
+template <typename OBJECT>
+ChanSender<OBJECT> makeSender(const OBJECT* first,
+                              const OBJECT* last,
+                              std::size_t*  numSent) {
+    assert(first < last);
+
+    ChanSender<OBJECT> sender = makeSender(first);
+    sender.count              = last - first;
+    sender.numTransferred     = numSent;
+    return sender;
+}
+
+template <typename OBJECT>
+SendManyEvent<OBJECT>::SendManyEvent(ChanState<OBJECT>& chanState,
+                                     OBJECT*            first,
+                                     OBJECT*            last,
+                                     std::size_t*       numSent)
+: Base(chanState, makeSender(first, last, numSent)) {
+}
+
+template <typename OBJECT>
+SendManyEvent<OBJECT>::SendManyEvent(ChanState<OBJECT>& chanState,
+                                     const OBJECT*      first,
+                                     const OBJECT*      last,
+                                     std::size_t*       numSent)
+: Base(chanState, makeSender(first, last, numSent)) {
+}
+
+template <typename OBJECT>
+SendManyEvent<OBJECT>::operator std::size_t() const {
+    std::size_t numSent;
+    this->me.numTransferred = &numSent;
+
+    // `select` operates on a copy of this event, which relieves this one of
+    // selecting upon itself when it's destroyed.
+    if (select(*this)) {
+        throw lastError();
+    }
+
+    return numSent;
+}
+
 }  // namespace chan
 
 #endif
@@ -0,0 +1 @@
+#include <chan/chanevents/spscevent.h>
@@ -0,0 +1,308 @@
+#ifndef INCLUDED_CHAN_CHANEVENTS_SPSCEVENT
+#define INCLUDED_CHAN_CHANEVENTS_SPSCEVENT
+
+// This component provides the events of `SpscChan` (see
+// `chan/chan/spscchan.h`): `SpscSendEvent` and `SpscRecvEvent`.  Like
+// `SendEvent` and `RecvEvent`, they share their logic in a class template,
+// `SpscEvent`, whose `POLICY` says which side of the `SpscState` it's on.
+//
+// An `SpscEvent` never locks anything.  It first tries to push onto or pop
+// from the ring.  Only if the ring is full or empty, respectively, does it
+// park the thread's `ThreadWakeup` in the `SpscState` and wait on it like a
+// `Chan` event does, and then try again when the other side wakes it.
+//
+// Neither side of an `SpscChan` can be involved in more than one event at a
+// time, so an `SpscEvent` doesn't need its `EventContext`: no other event can
+// change the ring on its side, and the other side never fulfills it.
+
+#include <chan/chanstate/spscstate.h>
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/errors/noexcept.h>
+#include <chan/errors/uncaughtexceptions.h>
+#include <chan/event/eventcontext.h>
+#include <chan/event/ioevent.h>
+#include <chan/files/threadwakeup.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/select.h>
+#include <chan/select/selectone.h>
+
+#include <cassert>
+#include <exception>
+
+namespace chan {
+
+template <typename OBJECT>
+struct SpscSender {
+    // Exactly one of these is set.  In C++98, "move" means swap.
+    OBJECT*       moveFrom;
+    const OBJECT* copyFrom;
+};
+
+template <typename OBJECT>
+struct SpscReceiver {
+    OBJECT* destination;
+};
+
+template <typename OBJECT>
+struct SpscSendEventPolicy {
+    typedef SpscState<OBJECT>  State;
+    typedef SpscSender<OBJECT> Endpoint;
+
+    static typename State::Side mySide() {
+        return State::SENDER;
+    }
+
+    static typename State::Side theirSide() {
+        return State::RECEIVER;
+    }
+
+    static bool transfer(State& state, const Endpoint& me) {
+        return me.moveFrom ? state.tryPushMove(*me.moveFrom)
+                           : state.tryPushCopy(*me.copyFrom);
+    }
+};
+
+template <typename OBJECT>
+struct SpscRecvEventPolicy {
+    typedef SpscState<OBJECT>    State;
+    typedef SpscReceiver<OBJECT> Endpoint;
+
+    static typename State::Side mySide() {
+        return State::RECEIVER;
+    }
+
+    static typename State::Side theirSide() {
+        return State::SENDER;
+    }
+
+    static bool transfer(State& state, const Endpoint& me) {
+        return state.tryPop(me.destination);
+    }
+};
+
+template <typename POLICY>
+class SpscEvent {
+  public:
+    typedef typename POLICY::State    State;
+    typedef typename POLICY::Endpoint Endpoint;
+
+  private:
+    Endpoint      me;
+    State&        state;
+    ThreadWakeup* parkedWakeup;  // my thread's, while parked in `state`
+    mutable bool  selectOnDestroy;
+
+  public:
+    SpscEvent(State& state, const Endpoint& me);
+    SpscEvent(const SpscEvent& other);
+    ~SpscEvent() CHAN_THROWS;
+
+    void    touch() CHAN_NOEXCEPT;
+    IoEvent file(const EventContext&);
+    IoEvent fulfill(IoEvent);
+    void    cancel(IoEvent);
+
+  private:
+    // Transfer between me and the ring, and if that succeeds, wake the other
+    // side if it's parked, and return `true`.  Otherwise, return `false`.
+    bool attempt();
+
+    // Park my thread's `ThreadWakeup`, and then attempt the transfer once
+    // more, since the other side might have changed the ring without seeing
+    // me parked.  Return the `IoEvent` to wait on, or a fulfilled one.
+    IoEvent park();
+
+    // Withdraw my `ThreadWakeup` if it's parked, consuming the wakeup that
+    // the other side posted if it took the `ThreadWakeup` first.
+    void unpark();
+};
+
+template <typename POLICY>
+SpscEvent<POLICY>::SpscEvent(State& state, const Endpoint& me)
+: me(me)
+, state(state)
+, parkedWakeup()
+, selectOnDestroy(true) {
+}
+
+template <typename POLICY>
+SpscEvent<POLICY>::SpscEvent(const SpscEvent& other)
+: me(other.me)
+, state(other.state)
+, parkedWakeup()
+, selectOnDestroy(other.selectOnDestroy) {
+    assert(!other.parkedWakeup);
+    other.selectOnDestroy = false;
+}
+
+template <typename POLICY>
+SpscEvent<POLICY>::~SpscEvent() CHAN_THROWS {
+    if (!selectOnDestroy || uncaughtExceptions()) {
+        return;
+    }
+
+    // Usually the ring is ready, in which case there's no need for `select`.
+    // If the transfer throws, report it as `select` would have.
+    bool done;
+    try {
+        done = attempt();
+    }
+    catch (const Error&) {
+        throw;
+    }
+    catch (const std::exception& error) {
+        throw Error(error.what());
+    }
+    catch (...) {
+        throw Error(ErrorCode::OTHER);
+    }
+
+    if (!done && selectOne(EventRef(*this))) {
+        throw lastError();
+    }
+}
+
+template <typename POLICY>
+void SpscEvent<POLICY>::touch() CHAN_NOEXCEPT {
+    // I'm being called by `select`, so there's no need to call `select` in my
+    // destructor.
+    selectOnDestroy = false;
+}
+
+template <typename POLICY>
+IoEvent SpscEvent<POLICY>::file(const EventContext&) {
+    if (attempt()) {
+        IoEvent event;
+        event.fulfilled = true;
+        return event;
+    }
+
+    return park();
+}
+
+template <typename POLICY>
+IoEvent SpscEvent<POLICY>::fulfill(IoEvent event) {
+    assert(parkedWakeup);
+    assert(event.read);
+    assert(event.file == parkedWakeup->waitFile);
+
+    if (state.isParked(POLICY::mySide())) {
+        // The other side hasn't taken my `ThreadWakeup`, so the wakeup was for
+        // some other event on my thread.  Keep waiting.
+        return event;
+    }
+
+    // The other side changed the ring and then took my `ThreadWakeup` in
+    // order to post to it.  Consume that wakeup, and try again.
+    ThreadWakeup* const wakeup = parkedWakeup;
+    parkedWakeup               = 0;
+    consumeWakeup(*wakeup);
+
+    if (attempt()) {
+        event.fulfilled = true;
+        return event;
+    }
+
+    return park();
+}
+
+template <typename POLICY>
+void SpscEvent<POLICY>::cancel(IoEvent) {
+    unpark();
+}
+
+template <typename POLICY>
+bool SpscEvent<POLICY>::attempt() {
+    if (!POLICY::transfer(state, me)) {
+        return false;
+    }
+
+    state.wake(POLICY::theirSide());
+    return true;
+}
+
+template <typename POLICY>
+IoEvent SpscEvent<POLICY>::park() {
+    assert(!parkedWakeup);
+
+    ThreadWakeup& wakeup = threadWakeup();
+    state.park(POLICY::mySide(), wakeup);
+    parkedWakeup = &wakeup;
+
+    bool done;
+    try {
+        done = attempt();
+    }
+    catch (...) {
+        unpark();
+        throw;
+    }
+
+    IoEvent event;
+    if (done) {
+        unpark();
+        event.fulfilled = true;
+        return event;
+    }
+
+    event.read         = true;
+    event.notification = true;
+    event.file         = wakeup.waitFile;
+    return event;
+}
+
+template <typename POLICY>
+void SpscEvent<POLICY>::unpark() {
+    if (!parkedWakeup) {
+        return;
+    }
+
+    ThreadWakeup* const wakeup = parkedWakeup;
+    parkedWakeup               = 0;
+    if (!state.unpark(POLICY::mySide())) {
+        consumeWakeup(*wakeup);
+    }
+}
+
+template <typename OBJECT>
+class SpscSendEvent : public SpscEvent<SpscSendEventPolicy<OBJECT> > {
+    typedef SpscEvent<SpscSendEventPolicy<OBJECT> > Base;
+
+    static SpscSender<OBJECT> makeSender(OBJECT* moveFrom,
+                                         const OBJECT* copyFrom) {
+        const SpscSender<OBJECT> sender = { moveFrom, copyFrom };
+        return sender;
+    }
+
+  public:
+    SpscSendEvent(SpscState<OBJECT>& state, OBJECT* source)
+    : Base(state, makeSender(source, 0)) {
+        assert(source);
+    }
+
+    SpscSendEvent(SpscState<OBJECT>& state, const OBJECT* source)
+    : Base(state, makeSender(0, source)) {
+        assert(source);
+    }
+};
+
+template <typename OBJECT>
+class SpscRecvEvent : public SpscEvent<SpscRecvEventPolicy<OBJECT> > {
+    typedef SpscEvent<SpscRecvEventPolicy<OBJECT> > Base;
+
+    static SpscReceiver<OBJECT> makeReceiver(OBJECT* destination) {
+        const SpscReceiver<OBJECT> receiver = { destination };
+        return receiver;
+    }
+
+  public:
+    SpscRecvEvent(SpscState<OBJECT>& state, OBJECT* destination)
+    : Base(state, makeReceiver(destination)) {
+        assert(destination);
+    }
+};
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_CHANBUFFER
+#define INCLUDED_CHAN_CHANSTATE_CHANBUFFER
+
+// This component provides `ChanBuffer`, the ring buffer of a buffered `Chan`.
+// A `ChanBuffer` has a fixed capacity, chosen when it's created, and holds
+// that many objects in one contiguous allocation.  Objects are constructed in
+// place when they're pushed, and destroyed when they're popped.
+//
+// `ChanBuffer` is not thread-safe.  `ChanState` protects it with its mutex.
+//
+// `ChanBuffer<void>` holds no objects, only a count.
+//
+// Objects can also be pushed and popped several at a time.  If `OBJECT` is
+// trivially copyable (C++11), then they're copied using `std::memcpy`, in at
+// most two pieces, since the free slots or the objects in the ring may wrap
+// around the end of the storage.
+//
+// An object can also be constructed directly in its slot by a function that's
+// given the slot's address (`emplaceUsing`), and popped by constructing it
+// into an `Optional` rather than by assigning it to an existing object, so
+// that `OBJECT` needn't be default constructible.
+
+#include <chan/chanstate/optional.h>
+
+#include <algorithm>  // std::min, std::swap
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <cstring>  // std::memcpy
+#include <new>
+#include <utility>  // std::move (if C++11)
+#if __cplusplus >= 201103
+#include <type_traits>
+#endif
+
+namespace chan {
+
+// Return whether `OBJECT`s can be copied and moved using `std::memcpy`.  This
+// is always `false` in C++98, where there's no way to tell.
+template <typename OBJECT>
+bool isTriviallyCopyable() {
+#if __cplusplus >= 201103
+    return std::is_trivially_copyable<OBJECT>::value;
+#else
+    return false;
+#endif
+}
+
+template <typename OBJECT>
+class ChanBuffer {
+    OBJECT*     slots;      // storage for `capacity()` objects, or null
+    std::size_t numSlots;   // capacity
+    std::size_t head;       // position of the oldest object
+    std::size_t numInUse;   // number of objects
+
+    ChanBuffer(const ChanBuffer&) /* = delete */;
+    ChanBuffer& operator=(const ChanBuffer&) /* = delete */;
+
+    // Return the position at which the next pushed object goes.
+    OBJECT* tail() {
+        const std::size_t index = head + numInUse;
+        return slots + (index < numSlots ? index : index - numSlots);
+    }
+
+    void popped() {
+        ++head;
+        if (head == numSlots) {
+            head = 0;
+        }
+        --numInUse;
+    }
+
+    // Append the specified `count` objects at `source` using `std::memcpy`.
+    // The behavior is undefined unless `OBJECT` is trivially copyable and
+    // there's room for them.
+    void copyIn(const OBJECT* source, std::size_t count);
+
+    // Remove the specified `count` oldest objects into the consecutive
+    // objects at `destination` using `std::memcpy`.  The behavior is
+    // undefined unless `OBJECT` is trivially copyable and there are that
+    // many.
+    void copyOut(OBJECT* destination, std::size_t count);
+
+  public:
+    // Create an empty `ChanBuffer` able to hold the specified `capacity`
+    // objects.  Capacity zero means an unbuffered `Chan`.
+    explicit ChanBuffer(std::size_t capacity);
+
+    // Destroy any objects remaining, and free the storage.
+    ~ChanBuffer();
+
+    std::size_t capacity() const;
+    bool        empty() const;
+    bool        full() const;
+
+    // Append a copy of the specified `object`.  If the copy constructor
+    // throws, this object is unchanged.  The behavior is undefined if
+    // `full()`.
+    void pushCopy(const OBJECT& object);
+
+    // Append the value of the specified `object`, leaving `object` in a
+    // moved-from state (C++11), or with the value of a default constructed
+    // `OBJECT` (C++98, where the two are swapped).  The behavior is undefined
+    // if `full()`.
+    void pushMove(OBJECT& object);
+
+    // Move the oldest object into the specified `destination` (swap, in
+    // C++98), and remove it.  If the assignment throws, this object is
+    // unchanged.  The behavior is undefined if `empty()`.
+    void pop(OBJECT* destination);
+
+    // Append an object constructed by calling the specified `construct` with
+    // the address of uninitialized storage for it.  If `construct` throws, it
+    // must not have constructed the object, and this object is unchanged.
+    // The behavior is undefined if `full()`.
+    template <typename CONSTRUCTOR>
+    void emplaceUsing(const CONSTRUCTOR& construct);
+
+    // Move the oldest object into the specified `slot`, constructing it there
+    // (copy, in C++98), and remove it.  If the constructor throws, this
+    // object is unchanged.  The behavior is undefined if `empty()`.
+    void pop(Optional<OBJECT>* slot);
+
+    // Append copies of as many of the specified `count` objects at `source`
+    // as there's room for, and return how many.  If a copy constructor
+    // throws, the objects appended before it remain.
+    std::size_t pushCopies(const OBJECT* source, std::size_t count);
+
+    // Append the values of as many of the specified `count` objects at
+    // `source` as there's room for, leaving each as `pushMove` does, and
+    // return how many.  If a constructor throws, the objects appended before
+    // it remain.
+    std::size_t pushMoves(OBJECT* source, std::size_t count);
+
+    // Move as many of the specified `count` oldest objects as there are into
+    // the consecutive objects at `destination`, as `pop` does, removing them,
+    // and return how many.  If an assignment throws, the objects moved before
+    // it are removed.
+    std::size_t popMany(OBJECT* destination, std::size_t count);
+};
+
+template <>
+class ChanBuffer<void> {
+    std::size_t numSlots;
+    std::size_t numInUse;
+
+  public:
+    explicit ChanBuffer(std::size_t capacity)
+    : numSlots(capacity)
+    , numInUse() {
+    }
+
+    std::size_t capacity() const {
+        return numSlots;
+    }
+
+    bool empty() const {
+        return numInUse == 0;
+    }
+
+    bool full() const {
+        return numInUse == numSlots;
+    }
+
+    void push() {
+        assert(!full());
+        ++numInUse;
+    }
+
+    void pop() {
+        assert(!empty());
+        --numInUse;
+    }
+};
+
+template <typename OBJECT>
+ChanBuffer<OBJECT>::ChanBuffer(std::size_t capacity)
+: slots(capacity ? static_cast<OBJECT*>(::operator new(capacity *
+                                                       sizeof(OBJECT)))
+                 : 0)
+, numSlots(capacity)
+, head()
+, numInUse() {
+}
+
+template <typename OBJECT>
+ChanBuffer<OBJECT>::~ChanBuffer() {
+    while (numInUse) {
+        slots[head].~OBJECT();
+        popped();
+    }
+
+    ::operator delete(slots);
+}
+
+template <typename OBJECT>
+std::size_t ChanBuffer<OBJECT>::capacity() const {
+    return numSlots;
+}
+
+template <typename OBJECT>
+bool ChanBuffer<OBJECT>::empty() const {
+    return numInUse == 0;
+}
+
+template <typename OBJECT>
+bool ChanBuffer<OBJECT>::full() const {
+    return numInUse == numSlots;
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::pushCopy(const OBJECT& object) {
+    assert(!full());
+    new (tail()) OBJECT(object);
+    ++numInUse;
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::pushMove(OBJECT& object) {
+    assert(!full());
+#if __cplusplus >= 201103
+    new (tail()) OBJECT(std::move(object));
+#else
+    OBJECT* const slot = new (tail()) OBJECT();
+    using std::swap;
+    swap(*slot, object);
+#endif
+    ++numInUse;
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::pop(OBJECT* destination) {
+    assert(!empty());
+    assert(destination);
+
+    OBJECT& oldest = slots[head];
+#if __cplusplus >= 201103
+    *destination = std::move(oldest);
+#else
+    using std::swap;
+    swap(*destination, oldest);
+#endif
+    oldest.~OBJECT();
+    popped();
+}
+
+template <typename OBJECT>
+template <typename CONSTRUCTOR>
+void ChanBuffer<OBJECT>::emplaceUsing(const CONSTRUCTOR& construct) {
+    assert(!full());
+    construct(static_cast<void*>(tail()));
+    ++numInUse;
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::pop(Optional<OBJECT>* slot) {
+    assert(!empty());
+    assert(slot);
+
+    OBJECT& oldest = slots[head];
+#if __cplusplus >= 201103
+    slot->emplace(std::move(oldest));
+#else
+    slot->emplace(oldest);
+#endif
+    oldest.~OBJECT();
+    popped();
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::copyIn(const OBJECT* source, std::size_t count) {
+    assert(count <= numSlots - numInUse);
+
+    OBJECT* const     end         = tail();
+    const std::size_t beforeWrap  = slots + numSlots - end;
+    const std::size_t firstPiece  = std::min(count, beforeWrap);
+    const std::size_t objectBytes = sizeof(OBJECT);
+
+    std::memcpy(static_cast<void*>(end), source, firstPiece * objectBytes);
+    std::memcpy(static_cast<void*>(slots),
+                source + firstPiece,
+                (count - firstPiece) * objectBytes);
+    numInUse += count;
+}
+
+template <typename OBJECT>
+void ChanBuffer<OBJECT>::copyOut(OBJECT* destination, std::size_t count) {
+    assert(count <= numInUse);
+
+    const std::size_t firstPiece  = std::min(count, numSlots - head);
+    const std::size_t objectBytes = sizeof(OBJECT);
+
+    std::memcpy(static_cast<void*>(destination),
+                slots + head,
+                firstPiece * objectBytes);
+    std::memcpy(static_cast<void*>(destination + firstPiece),
+                slots,
+                (count - firstPiece) * objectBytes);
+
+    head += count;
+    if (head >= numSlots) {
+        head -= numSlots;
+    }
+    numInUse -= count;
+}
+
+template <typename OBJECT>
+std::size_t ChanBuffer<OBJECT>::pushCopies(const OBJECT* source,
+                                           std::size_t   count) {
+    assert(source);
+
+    const std::size_t numToPush = std::min(count, numSlots - numInUse);
+    if (isTriviallyCopyable<OBJECT>()) {
+        copyIn(source, numToPush);
+        return numToPush;
+    }
+
+    for (std::size_t i = 0; i < numToPush; ++i) {
+        pushCopy(source[i]);
+    }
+    return numToPush;
+}
+
+template <typename OBJECT>
+std::size_t ChanBuffer<OBJECT>::pushMoves(OBJECT* source, std::size_t count) {
+    assert(source);
+
+    const std::size_t numToPush = std::min(count, numSlots - numInUse);
+    if (isTriviallyCopyable<OBJECT>()) {
+        copyIn(source, numToPush);
+        return numToPush;
+    }
+
+    for (std::size_t i = 0; i < numToPush; ++i) {
+        pushMove(source[i]);
+    }
+    return numToPush;
+}
+
+template <typename OBJECT>
+std::size_t ChanBuffer<OBJECT>::popMany(OBJECT*     destination,
+                                        std::size_t count) {
+    assert(destination);
+
+    const std::size_t numToPop = std::min(count, numInUse);
+    if (isTriviallyCopyable<OBJECT>()) {
+        copyOut(destination, numToPop);
+        return numToPop;
+    }
+
+    for (std::size_t i = 0; i < numToPop; ++i) {
+        pop(destination + i);
+    }
+    return numToPop;
+}
+
+}  // namespace chan
+
+#endif
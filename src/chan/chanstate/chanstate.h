@@ -1,17 +1,23 @@
 #ifndef INCLUDED_CHAN_CHANSTATE_CHANSTATE
 #define INCLUDED_CHAN_CHANSTATE_CHANSTATE
 
+#include <chan/chanstate/chanbuffer.h>
+#include <chan/chanstate/mailbox.h>
+#include <chan/chanstate/mailboxpool.h>
+#include <chan/chanstate/optional.h>
+#include <chan/chanstate/waiterlist.h>
 #include <chan/event/eventcontext.h>
-#include <chan/files/pipe.h>
-#include <chan/files/pipepool.h>
 
-#include <list>
+#include <cstddef>  // std::size_t
 
 namespace chan {
 
 // `ChanParticipant` are the fields common to `ChanSender` and `SendReceiver`.
-struct ChanParticipant {
-    Pipe*        pipe;
+// A waiting participant is linked into its `ChanState` as itself, i.e. the
+// node is the participant within the waiting event (see
+// `chan/chanstate/waiterlist.h`).
+struct ChanParticipant : public WaiterLink {
+    Mailbox*     mailbox;
     EventContext context;
 
     // We were poked but have yet to respond to it.  This flag is used to avoid
@@ -20,40 +26,92 @@ struct ChanParticipant {
     // visit the other.  Checking `isPoked` prevents that case.
     bool isPoked;
 
+    // A participant sends, or has room to receive, `count` objects, which are
+    // consecutive in memory.  It's one unless the participant belongs to a
+    // `SendManyEvent` or `RecvUpToEvent`.  However many objects are actually
+    // transferred, which is at least one, are stored into `*numTransferred`,
+    // unless it's null.  `numTransferred` is `mutable` for use in the
+    // conversion operators of those events.
+    std::size_t          count;
+    mutable std::size_t* numTransferred;
+
     ChanParticipant()
-    : pipe()
+    : WaiterLink()
+    , mailbox()
     , context()
-    , isPoked() {
+    , isPoked()
+    , count(1)
+    , numTransferred() {
+    }
+};
+
+// A `ChanEmplacer` constructs an object at a specified address using
+// constructor arguments that only it knows the types of.  `construct` is given
+// the address and `arguments`, and either constructs an object there or
+// throws.  A `ChanEmplacer` is used with `Optional::emplaceUsing`.
+struct ChanEmplacer {
+    void (*construct)(void* storage, const void* arguments);
+    const void* arguments;
+
+    void operator()(void* storage) const {
+        construct(storage, arguments);
     }
 };
 
 template <typename OBJECT>
 struct ChanSender : public ChanParticipant {
     // In C++98, using the `MOVE` `TransferMode` performs a swap instead of a
-    // move.  The real difference between the two values of this `enum` is
-    // which of the members of the union below will be accessed.
-    enum TransferMode { MOVE, COPY } transferMode;
+    // move.  The real difference between the values of this `enum` is which
+    // of the members of the union below will be accessed.  An `EMPLACE`
+    // sender has no object yet; `emplacer` constructs it wherever it's going,
+    // so that the object sent is constructed exactly once (`count` is one).
+    enum TransferMode { MOVE, COPY, EMPLACE } transferMode;
 
     union {
         OBJECT*       moveFrom;
         const OBJECT* copyFrom;
+        ChanEmplacer  emplacer;
     };
 };
 
 template <typename OBJECT>
 struct ChanReceiver : public ChanParticipant {
-    OBJECT* destination;
+    // An `ASSIGN` receiver assigns to `count` existing objects starting at
+    // `destination`.  A `CONSTRUCT` receiver instead constructs one object in
+    // `*slot`, which needn't contain one already, so that `OBJECT` needn't be
+    // default constructible.
+    enum TransferMode { ASSIGN, CONSTRUCT } transferMode;
+
+    union {
+        OBJECT*           destination;
+        Optional<OBJECT>* slot;
+    };
 };
 
+// A `ChanState` is everything that the `SendEvent`s and `RecvEvent`s of one
+// `Chan` share.  If `buffer` has nonzero capacity, then the `Chan` is
+// buffered: senders and receivers never meet, but instead push onto and pop
+// from `buffer`, and `senders` and `receivers` are those waiting for `buffer`
+// to become not full or not empty, respectively.  Otherwise, they're those
+// waiting to meet each other.
 template <typename OBJECT>
 struct ChanState {
-    Mutex                            mutex;
-    std::list<ChanSender<OBJECT> >   senders;
-    std::list<ChanReceiver<OBJECT> > receivers;
+    Mutex                             mutex;
+    WaiterList<ChanSender<OBJECT> >   senders;
+    WaiterList<ChanReceiver<OBJECT> > receivers;
+    ChanBuffer<OBJECT>                buffer;
 
-    // `PipePool` manages concurrent access using its own `Mutex`, so I put it
-    // apart from the other data members.
-    PipePool pipePool;
+    // `MailboxPool` manages concurrent access using its own `Mutex`, so I put
+    // it apart from the other data members.
+    MailboxPool mailboxPool;
+
+    explicit ChanState(std::size_t capacity = 0)
+    : mutex()
+    , senders()
+    , receivers()
+    , buffer(capacity)
+    , mailboxPool() {
+    }
 };
 
 }  // namespace chan
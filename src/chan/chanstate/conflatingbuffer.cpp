@@ -0,0 +1 @@
+#include <chan/chanstate/conflatingbuffer.h>
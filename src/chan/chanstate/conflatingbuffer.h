@@ -0,0 +1,275 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_CONFLATINGBUFFER
+#define INCLUDED_CHAN_CHANSTATE_CONFLATINGBUFFER
+
+// This component provides `ConflatingBuffer`, the pending values of a
+// `ConflatingChan` (see `chan/chan/conflatingchan.h`).  A `ConflatingBuffer`
+// holds at most one value per key, where the key of a value is given by a
+// function chosen when the buffer is created.  Putting a value whose key is
+// already pending overwrites the pending value, keeping its place in line;
+// otherwise the value goes to the back of the line.  Popping takes the value
+// at the front, i.e. the one whose key has been pending the longest.  So the
+// buffer never fills up, and it holds no more values than there are keys.
+//
+// `ConflatingBuffer<OBJECT, void>` has no keys: it holds at most one value,
+// the latest.
+//
+// `ConflatingBuffer` is not thread-safe.  `ConflatingState` protects it with
+// its mutex.
+
+#include <chan/chanstate/optional.h>
+
+#include <algorithm>  // std::swap
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <list>
+#include <map>
+#include <utility>  // std::move (if C++11)
+
+namespace chan {
+
+template <typename OBJECT, typename KEY>
+class ConflatingBuffer {
+  public:
+    typedef KEY (*KeyFunction)(const OBJECT&);
+
+  private:
+    typedef std::list<OBJECT>                      Line;
+    typedef std::map<KEY, typename Line::iterator> Positions;
+
+    KeyFunction keyOf;
+    Line        line;       // pending values, the longest pending in front
+    Positions   positions;  // where each pending key's value is in `line`
+
+    ConflatingBuffer(const ConflatingBuffer&) /* = delete */;
+    ConflatingBuffer& operator=(const ConflatingBuffer&) /* = delete */;
+
+    // Return the position of the key of the value at the front of `line`.
+    // This must be looked up before the value is moved from.
+    typename Positions::iterator frontPosition();
+
+    // Remove the value at the front of `line`, and its key, at the specified
+    // `position`.
+    void popped(typename Positions::iterator position);
+
+  public:
+    // Create an empty `ConflatingBuffer` that keys values using the specified
+    // `keyOf`.
+    explicit ConflatingBuffer(KeyFunction keyOf);
+
+    bool        empty() const;
+    std::size_t size() const;
+
+    // Put a copy of the specified `object`, overwriting the pending value
+    // that has the same key, if any.  If an exception is thrown, this object
+    // is unchanged, except that a pending value being overwritten might be
+    // left as the assignment operator leaves it.
+    void putCopy(const OBJECT& object);
+
+    // Put the value of the specified `object` as `putCopy` does, but leaving
+    // `object` in a moved-from state (C++11), or with the value that it
+    // swapped with (C++98).
+    void putMove(OBJECT& object);
+
+    // Move the value at the front into the specified `destination` (swap, in
+    // C++98), and remove it.  If the assignment throws, this object is
+    // unchanged.  The behavior is undefined if `empty()`.
+    void pop(OBJECT* destination);
+
+    // Move the value at the front into the specified `slot`, constructing it
+    // there (copy, in C++98), and remove it.  If the constructor throws, this
+    // object is unchanged.  The behavior is undefined if `empty()`.
+    void pop(Optional<OBJECT>* slot);
+};
+
+template <typename OBJECT>
+class ConflatingBuffer<OBJECT, void> {
+    Optional<OBJECT> latest;
+
+    ConflatingBuffer(const ConflatingBuffer&) /* = delete */;
+    ConflatingBuffer& operator=(const ConflatingBuffer&) /* = delete */;
+
+  public:
+    ConflatingBuffer()
+    : latest() {
+    }
+
+    bool empty() const {
+        return !latest.hasValue();
+    }
+
+    std::size_t size() const {
+        return latest.hasValue();
+    }
+
+    void putCopy(const OBJECT& object) {
+        if (latest.hasValue()) {
+            *latest = object;
+        }
+        else {
+            latest.emplace(object);
+        }
+    }
+
+    void putMove(OBJECT& object) {
+        if (latest.hasValue()) {
+#if __cplusplus >= 201103
+            *latest = std::move(object);
+#else
+            using std::swap;
+            swap(*latest, object);
+#endif
+        }
+        else {
+#if __cplusplus >= 201103
+            latest.emplace(std::move(object));
+#else
+            latest.emplace(object);
+#endif
+        }
+    }
+
+    void pop(OBJECT* destination) {
+        assert(!empty());
+        assert(destination);
+#if __cplusplus >= 201103
+        *destination = std::move(*latest);
+#else
+        using std::swap;
+        swap(*destination, *latest);
+#endif
+        latest.reset();
+    }
+
+    void pop(Optional<OBJECT>* slot) {
+        assert(!empty());
+        assert(slot);
+#if __cplusplus >= 201103
+        slot->emplace(std::move(*latest));
+#else
+        slot->emplace(*latest);
+#endif
+        latest.reset();
+    }
+};
+
+template <typename OBJECT, typename KEY>
+ConflatingBuffer<OBJECT, KEY>::ConflatingBuffer(KeyFunction keyOf)
+: keyOf(keyOf)
+, line()
+, positions() {
+    assert(keyOf);
+}
+
+template <typename OBJECT, typename KEY>
+bool ConflatingBuffer<OBJECT, KEY>::empty() const {
+    return line.empty();
+}
+
+template <typename OBJECT, typename KEY>
+std::size_t ConflatingBuffer<OBJECT, KEY>::size() const {
+    return positions.size();
+}
+
+template <typename OBJECT, typename KEY>
+typename ConflatingBuffer<OBJECT, KEY>::Positions::iterator
+ConflatingBuffer<OBJECT, KEY>::frontPosition() {
+    const typename Positions::iterator position =
+        positions.find(keyOf(line.front()));
+    assert(position != positions.end());
+    assert(position->second == line.begin());
+    return position;
+}
+
+template <typename OBJECT, typename KEY>
+void ConflatingBuffer<OBJECT, KEY>::popped(
+    typename Positions::iterator position) {
+    positions.erase(position);
+    line.pop_front();
+}
+
+template <typename OBJECT, typename KEY>
+void ConflatingBuffer<OBJECT, KEY>::putCopy(const OBJECT& object) {
+    const KEY                          key      = keyOf(object);
+    const typename Positions::iterator position = positions.find(key);
+    if (position != positions.end()) {
+        *position->second = object;
+        return;
+    }
+
+    line.push_back(object);
+    try {
+        positions.insert(std::make_pair(key, --line.end()));
+    }
+    catch (...) {
+        line.pop_back();
+        throw;
+    }
+}
+
+template <typename OBJECT, typename KEY>
+void ConflatingBuffer<OBJECT, KEY>::putMove(OBJECT& object) {
+    const KEY                          key      = keyOf(object);
+    const typename Positions::iterator position = positions.find(key);
+    if (position != positions.end()) {
+#if __cplusplus >= 201103
+        *position->second = std::move(object);
+#else
+        using std::swap;
+        swap(*position->second, object);
+#endif
+        return;
+    }
+
+#if __cplusplus >= 201103
+    line.push_back(std::move(object));
+#else
+    line.push_back(OBJECT());
+    using std::swap;
+    swap(line.back(), object);
+#endif
+    try {
+        positions.insert(std::make_pair(key, --line.end()));
+    }
+    catch (...) {
+#if __cplusplus >= 201103
+        object = std::move(line.back());
+#else
+        swap(line.back(), object);
+#endif
+        line.pop_back();
+        throw;
+    }
+}
+
+template <typename OBJECT, typename KEY>
+void ConflatingBuffer<OBJECT, KEY>::pop(OBJECT* destination) {
+    assert(!empty());
+    assert(destination);
+
+    const typename Positions::iterator position = frontPosition();
+#if __cplusplus >= 201103
+    *destination = std::move(line.front());
+#else
+    using std::swap;
+    swap(*destination, line.front());
+#endif
+    popped(position);
+}
+
+template <typename OBJECT, typename KEY>
+void ConflatingBuffer<OBJECT, KEY>::pop(Optional<OBJECT>* slot) {
+    assert(!empty());
+    assert(slot);
+
+    const typename Positions::iterator position = frontPosition();
+#if __cplusplus >= 201103
+    slot->emplace(std::move(line.front()));
+#else
+    slot->emplace(line.front());
+#endif
+    popped(position);
+}
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_CONFLATINGSTATE
+#define INCLUDED_CHAN_CHANSTATE_CONFLATINGSTATE
+
+#include <chan/chanstate/chanstate.h>
+#include <chan/chanstate/conflatingbuffer.h>
+#include <chan/chanstate/mailboxpool.h>
+#include <chan/chanstate/waiterlist.h>
+#include <chan/threading/mutex.h>
+
+namespace chan {
+
+// A `ConflatingState` is everything that the events of one `ConflatingChan`
+// share.  It's laid out like a `ChanState`, so that the same `ChanEvent`
+// logic applies, except that its buffer is a `ConflatingBuffer`, which is
+// never full.  So `senders` is always empty, and `receivers` are those
+// waiting for `buffer` to become not empty.
+template <typename OBJECT, typename KEY>
+struct ConflatingState {
+    typedef KEY (*KeyFunction)(const OBJECT&);
+
+    Mutex                             mutex;
+    WaiterList<ChanSender<OBJECT> >   senders;
+    WaiterList<ChanReceiver<OBJECT> > receivers;
+    ConflatingBuffer<OBJECT, KEY>     buffer;
+
+    // `MailboxPool` manages concurrent access using its own `Mutex`, so I put
+    // it apart from the other data members.
+    MailboxPool mailboxPool;
+
+    // Create a `ConflatingState` whose buffer holds one value, the latest.
+    // This is for when `KEY` is `void`.
+    ConflatingState()
+    : mutex()
+    , senders()
+    , receivers()
+    , buffer()
+    , mailboxPool() {
+    }
+
+    // Create a `ConflatingState` whose buffer holds one value per key, as
+    // given by the specified `keyOf`.
+    explicit ConflatingState(KeyFunction keyOf)
+    : mutex()
+    , senders()
+    , receivers()
+    , buffer(keyOf)
+    , mailboxPool() {
+    }
+};
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1 @@
+#include <chan/chanstate/mailbox.h>
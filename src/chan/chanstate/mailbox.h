@@ -0,0 +1,32 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_MAILBOX
+#define INCLUDED_CHAN_CHANSTATE_MAILBOX
+
+#include <chan/files/threadwakeup.h>
+
+namespace chan {
+
+// A `Mailbox` is how one participant in a channel sends channel protocol
+// messages (see `chan/chanevents/chanprotocol.h`) to another.  A message is
+// recorded in one of the `pending...` flags, and then the recipient's thread
+// is woken up using `wakeup`.  The recipient consumes that wakeup when it
+// takes the message.  A `ThreadWakeup` outlives any `Mailbox` referring to it
+// (see `chan/files/threadwakeup.h`).
+struct Mailbox {
+    ThreadWakeup* wakeup;
+
+    // reference counting
+    int referenceCount;
+
+    // Whether each kind of message has been sent but not yet taken, only ever
+    // accessed atomically.  They're separate because the senders of `POKE`
+    // hold the `ChanState`'s mutex, while the sender of `DONE` or `ERROR`
+    // is instead the visitor that fulfilled the recipient, which sends it
+    // without holding anything, after the transfer.
+    bool pendingDone;
+    bool pendingError;
+    bool pendingPoke;
+};
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,78 @@
+#include <chan/chanstate/mailboxpool.h>
+#include <chan/debug/trace.h>
+#include <chan/threading/lockguard.h>
+
+#include <cassert>
+
+namespace chan {
+
+MailboxPool::MailboxPool()
+: freeList() {
+}
+
+MailboxPool::~MailboxPool() {
+    const FreeListNode* node = freeList;
+    while (node) {
+        const FreeListNode* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+Mailbox* MailboxPool::allocate() {
+    // Get the thread's wakeup first, since it might throw.
+    ThreadWakeup& wakeup = threadWakeup();
+
+    FreeListNode* node = 0;
+    CHAN_WITH_LOCK(mutex) {
+        if (freeList) {
+            node     = freeList;
+            freeList = freeList->next;
+        }
+    }
+
+    if (node) {
+        CHAN_TRACE("Allocating recycled mailbox at ", node);
+    }
+    else {
+        node = new FreeListNode;
+        CHAN_TRACE("Allocating new mailbox at ", node);
+    }
+
+    Mailbox& mailbox       = *node;
+    mailbox.wakeup         = &wakeup;
+    mailbox.referenceCount = 1;
+    mailbox.pendingDone    = false;
+    mailbox.pendingError   = false;
+    mailbox.pendingPoke    = false;
+    return node;
+}
+
+void MailboxPool::deallocate(Mailbox* mailbox) {
+    assert(mailbox);
+
+    // The only way that the following `static_cast` could be valid is if
+    // `mailbox` really does refer to a `FreeListNode`.  Together with the fact
+    // that the definition of `FreeListNode` is private, that is why the
+    // contract of this function says: "The behavior is undefined unless
+    // `mailbox` was obtained from the result of a previous call to `allocate`
+    // [...]".
+    FreeListNode* node = static_cast<FreeListNode*>(mailbox);
+
+    CHAN_TRACE("Deallocating mailbox at ",
+               node,
+               ", whose reference count is ",
+               mailbox->referenceCount);
+
+    assert(mailbox->referenceCount == 0);
+    assert(!mailbox->pendingDone);
+    assert(!mailbox->pendingError);
+    assert(!mailbox->pendingPoke);
+
+    LockGuard lock(mutex);
+
+    node->next = freeList;
+    freeList   = node;
+}
+
+}  // namespace chan
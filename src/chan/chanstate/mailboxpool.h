@@ -0,0 +1,39 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_MAILBOXPOOL
+#define INCLUDED_CHAN_CHANSTATE_MAILBOXPOOL
+
+#include <chan/chanstate/mailbox.h>
+#include <chan/threading/mutex.h>
+
+namespace chan {
+
+class MailboxPool {
+    struct FreeListNode : public Mailbox {
+        FreeListNode* next;
+    };
+
+    Mutex         mutex;
+    FreeListNode* freeList;
+
+    MailboxPool(const MailboxPool&) /* = delete */;
+    MailboxPool& operator=(const MailboxPool&) /* = delete */;
+
+  public:
+    MailboxPool();
+    ~MailboxPool();
+
+    // Return a pointer to an empty `Mailbox` whose `referenceCount == 1` and
+    // whose `wakeup` is the calling thread's (see
+    // `chan/files/threadwakeup.h`).  The `Mailbox` must be deallocated before
+    // this `MailboxPool` is destroyed.  A `Mailbox` is deallocated by passing
+    // it to `deallocate`.
+    Mailbox* allocate();
+
+    // The behavior is undefined unless `mailbox` was obtained from the result
+    // of a previous call to `allocate`, its `referenceCount` is zero, and
+    // every message sent to it has been taken.
+    void deallocate(Mailbox* mailbox);
+};
+
+}  // namespace chan
+
+#endif
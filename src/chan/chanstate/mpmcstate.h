@@ -0,0 +1,423 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_MPMCSTATE
+#define INCLUDED_CHAN_CHANSTATE_MPMCSTATE
+
+// This component provides `MpmcState`, everything that the events of one
+// `MpmcChan` share (see `chan/chan/mpmcchan.h`).  Its buffer is Dmitry
+// Vyukov's bounded multi-producer/multi-consumer queue: each slot has a
+// sequence number that says whether the slot is ready to be pushed onto or
+// popped from on the current lap around the ring, and producers and
+// consumers claim positions with a compare-and-swap on `enqueuePosition` and
+// `dequeuePosition`, respectively.  No mutex is involved in pushing or
+// popping.
+//
+// A producer or consumer that finds the ring full or empty, respectively,
+// "parks" a `MpmcWaiter` in one of the `waiters` lists, and waits for a poke.
+// The lists are protected by `mutex`, but it's only locked by somebody that
+// is parking, or that has to poke somebody who is.  After each push, a
+// producer issues a full fence and then reads the count of parked consumers,
+// and only if it's nonzero does it lock `mutex` in order to poke the first
+// consumer not already poked (and likewise for consumers after each pop).
+// Parking increments the count, issues a full fence, and then tries the ring
+// again, so either the parker sees the change to the ring, or the one who
+// changed it sees the parker.
+//
+// As with the buffered `Chan` (see `chan/chanevents/chanevent.h`), a poke
+// means only that the ring might be ready.  A poked waiter that leaves
+// without acting on it passes the poke on if the ring is still ready.
+//
+// Once a position is claimed, the push or pop can't be undone, so `OBJECT`'s
+// move constructor and move assignment (default constructor and swap, in
+// C++98) must not throw.  A copy is made before the position is claimed.
+
+#include <chan/files/threadwakeup.h>
+#include <chan/threading/lockguard.h>
+#include <chan/threading/mutex.h>
+
+#include <algorithm>  // std::swap
+#include <cassert>
+#include <cstddef>  // std::size_t, std::ptrdiff_t
+#include <list>
+#include <new>
+#include <utility>  // std::move (if C++11)
+
+namespace chan {
+
+struct MpmcWaiter {
+    ThreadWakeup* wakeup;
+
+    // The waiter was poked but hasn't yet responded to it.  This is protected
+    // by the `MpmcState`'s `mutex`, and the poke is accompanied by a wakeup
+    // posted to `wakeup`, which the waiter consumes when it clears the flag.
+    bool isPoked;
+};
+
+template <typename OBJECT>
+class MpmcState {
+  public:
+    enum Side { SENDER, RECEIVER };
+
+    typedef std::list<MpmcWaiter> Waiters;
+
+  private:
+    // Only `sequence` is constructed when the ring is allocated.  `object` is
+    // constructed by each push and destroyed by each pop.
+    struct Slot {
+        std::size_t sequence;
+        OBJECT      object;
+    };
+
+    // Padding is a whole (typical) cache line, so that whatever the alignment
+    // of this object, the fields on either side of it never share a line.
+    enum { CACHE_LINE = 64 };
+
+    // set on construction, and then only read
+    Slot* const       slots;
+    const std::size_t mask;  // the number of slots is a power of two
+    char              padding0[CACHE_LINE];
+
+    std::size_t enqueuePosition;  // claimed by producers
+    char        padding1[CACHE_LINE];
+
+    std::size_t dequeuePosition;  // claimed by consumers
+    char        padding2[CACHE_LINE];
+
+    // the number of `waiters` on each `Side`.  These are read after every push
+    // and pop, but are written only when parking or leaving.
+    unsigned numParked[2];
+    char     padding3[CACHE_LINE];
+
+    Mutex   mutex;
+    Waiters waiters[2];
+
+    MpmcState(const MpmcState&) /* = delete */;
+    MpmcState& operator=(const MpmcState&) /* = delete */;
+
+    static std::size_t roundUp(std::size_t capacity);
+
+    // Claim a position to push onto, and return its `Slot`, or return null
+    // if the ring is full.
+    Slot* claimPush();
+
+    // Claim the oldest position to pop from, and return its `Slot`, or return
+    // null if the ring is empty.
+    Slot* claimPop();
+
+    // Whether a push (for `SENDER`) or a pop (for `RECEIVER`) would succeed
+    // now, were it attempted.
+    bool isReady(Side side) const;
+
+    // Poke the first of the `waiters` on the specified `side` that isn't
+    // already poked, if any, and return the wakeup to post for it after
+    // releasing `mutex`, or return null.  `mutex` must be locked.
+    ThreadWakeup* pokeFirstUnpoked(Side side);
+
+  public:
+    // Create an empty `MpmcState` able to hold at least the specified
+    // `capacity` objects.  The capacity is rounded up to a power of two, and
+    // is at least two.  The behavior is undefined unless `capacity` is
+    // positive.
+    explicit MpmcState(std::size_t capacity);
+
+    // Destroy any objects remaining, and free the storage.
+    ~MpmcState();
+
+    std::size_t capacity() const;
+
+    // Append a copy of the specified `object` and return `true`, or return
+    // `false` if the ring is full.  If the copy constructor throws, this
+    // object is unchanged.
+    bool tryPushCopy(const OBJECT& object);
+
+    // Append the value of the specified `object` and return `true`, or return
+    // `false` if the ring is full.  `object` is left in a moved-from state
+    // (C++11), or with the value of a default constructed `OBJECT` (C++98,
+    // where the two are swapped).
+    bool tryPushMove(OBJECT& object);
+
+    // Move (swap, in C++98) the oldest object into the specified
+    // `destination`, remove it, and return `true`, or return `false` if the
+    // ring is empty.
+    bool tryPop(OBJECT* destination);
+
+    // Append the only node of the specified `oneNode` to the `waiters` on
+    // the specified `side`, and then issue a full fence, after which the
+    // caller must check the ring again.  If an error occurs, throw an
+    // exception.
+    void park(Side side, Waiters& oneNode);
+
+    // If the specified `waiter`, parked on the specified `side`, has been
+    // poked, then clear the poke, consume its wakeup, and return `true`.
+    // Otherwise, return `false`.  If an error occurs, throw an exception.
+    bool takePoke(Side side, Waiters::iterator waiter);
+
+    // Remove the specified `waiter` from the `waiters` on the specified
+    // `side`, splicing it into the specified `removed`.  If it was poked,
+    // consume the wakeup and pass the poke on.  If an error occurs, throw an
+    // exception.
+    void unpark(Side side, Waiters::iterator waiter, Waiters& removed);
+
+    // Issue a full fence, and then, if anybody is parked on the specified
+    // `side`, poke one of them.  Call this after each push (for `RECEIVER`)
+    // or pop (for `SENDER`).  If an error occurs, throw an exception.
+    void wake(Side side);
+};
+
+template <typename OBJECT>
+std::size_t MpmcState<OBJECT>::roundUp(std::size_t capacity) {
+    // With only one slot, "ready to push at position `p + 1`" and "ready to
+    // pop at position `p`" would be the same sequence number, so there are
+    // always at least two.
+    std::size_t result = 2;
+    while (result < capacity) {
+        result *= 2;
+    }
+    return result;
+}
+
+template <typename OBJECT>
+MpmcState<OBJECT>::MpmcState(std::size_t capacity)
+: slots(static_cast<Slot*>(::operator new(roundUp(capacity) * sizeof(Slot))))
+, mask(roundUp(capacity) - 1)
+, enqueuePosition()
+, dequeuePosition()
+, mutex()
+, waiters() {
+    assert(capacity > 0);
+
+    // Slot `i` is first ready to be pushed onto at position `i`.
+    for (std::size_t i = 0; i <= mask; ++i) {
+        slots[i].sequence = i;
+    }
+    numParked[SENDER]   = 0;
+    numParked[RECEIVER] = 0;
+}
+
+template <typename OBJECT>
+MpmcState<OBJECT>::~MpmcState() {
+    // Everybody is gone by now, so there's no need for atomics.
+    for (std::size_t i = dequeuePosition; i != enqueuePosition; ++i) {
+        slots[i & mask].object.~OBJECT();
+    }
+
+    ::operator delete(slots);
+}
+
+template <typename OBJECT>
+std::size_t MpmcState<OBJECT>::capacity() const {
+    return mask + 1;
+}
+
+template <typename OBJECT>
+typename MpmcState<OBJECT>::Slot* MpmcState<OBJECT>::claimPush() {
+    std::size_t position =
+        __atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED);
+    for (;;) {
+        Slot&             slot = slots[position & mask];
+        const std::size_t sequence =
+            __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        const std::ptrdiff_t lap = sequence - position;
+
+        if (lap == 0) {
+            // The slot is free on this lap.  Claim it, unless another
+            // producer beats me to it, in which case `position` is reloaded.
+            if (__atomic_compare_exchange_n(&enqueuePosition,
+                                            &position,
+                                            position + 1,
+                                            true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                return &slot;
+            }
+        }
+        else if (lap < 0) {
+            return 0;  // the slot still holds an object from the last lap
+        }
+        else {
+            // Another producer already claimed this position.
+            position = __atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+template <typename OBJECT>
+typename MpmcState<OBJECT>::Slot* MpmcState<OBJECT>::claimPop() {
+    std::size_t position =
+        __atomic_load_n(&dequeuePosition, __ATOMIC_RELAXED);
+    for (;;) {
+        Slot&             slot = slots[position & mask];
+        const std::size_t sequence =
+            __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        const std::ptrdiff_t lap = sequence - (position + 1);
+
+        if (lap == 0) {
+            if (__atomic_compare_exchange_n(&dequeuePosition,
+                                            &position,
+                                            position + 1,
+                                            true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                return &slot;
+            }
+        }
+        else if (lap < 0) {
+            return 0;  // nothing has been pushed at this position yet
+        }
+        else {
+            position = __atomic_load_n(&dequeuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+template <typename OBJECT>
+bool MpmcState<OBJECT>::tryPushCopy(const OBJECT& object) {
+    // Copy first, since the copy constructor might throw.
+    OBJECT copy(object);
+    return tryPushMove(copy);
+}
+
+template <typename OBJECT>
+bool MpmcState<OBJECT>::tryPushMove(OBJECT& object) {
+    Slot* const slot = claimPush();
+    if (!slot) {
+        return false;
+    }
+
+#if __cplusplus >= 201103
+    new (&slot->object) OBJECT(std::move(object));
+#else
+    new (&slot->object) OBJECT();
+    using std::swap;
+    swap(slot->object, object);
+#endif
+
+    // The slot is now ready to be popped from on this lap, i.e. at the
+    // position claimed, plus one.
+    const std::size_t position = slot->sequence;
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename OBJECT>
+bool MpmcState<OBJECT>::tryPop(OBJECT* destination) {
+    assert(destination);
+
+    Slot* const slot = claimPop();
+    if (!slot) {
+        return false;
+    }
+
+#if __cplusplus >= 201103
+    *destination = std::move(slot->object);
+#else
+    using std::swap;
+    swap(*destination, slot->object);
+#endif
+    slot->object.~OBJECT();
+
+    // The slot is now ready to be pushed onto on the next lap.
+    const std::size_t position = slot->sequence - 1;
+    __atomic_store_n(&slot->sequence, position + mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename OBJECT>
+bool MpmcState<OBJECT>::isReady(Side side) const {
+    if (side == SENDER) {
+        const std::size_t position =
+            __atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED);
+        return __atomic_load_n(&slots[position & mask].sequence,
+                               __ATOMIC_ACQUIRE) == position;
+    }
+
+    const std::size_t position =
+        __atomic_load_n(&dequeuePosition, __ATOMIC_RELAXED);
+    return __atomic_load_n(&slots[position & mask].sequence,
+                           __ATOMIC_ACQUIRE) == position + 1;
+}
+
+template <typename OBJECT>
+ThreadWakeup* MpmcState<OBJECT>::pokeFirstUnpoked(Side side) {
+    Waiters& parked = waiters[side];
+    for (Waiters::iterator it = parked.begin(); it != parked.end(); ++it) {
+        if (!it->isPoked) {
+            it->isPoked = true;
+            return it->wakeup;
+        }
+    }
+
+    return 0;
+}
+
+template <typename OBJECT>
+void MpmcState<OBJECT>::park(Side side, Waiters& oneNode) {
+    assert(oneNode.size() == 1);
+    assert(!oneNode.front().isPoked);
+
+    CHAN_WITH_LOCK(mutex) {
+        waiters[side].splice(waiters[side].end(), oneNode);
+        __atomic_fetch_add(&numParked[side], 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+template <typename OBJECT>
+bool MpmcState<OBJECT>::takePoke(Side, Waiters::iterator waiter) {
+    LockGuard lock(mutex);
+    if (!waiter->isPoked) {
+        return false;
+    }
+
+    // The poker posts the wakeup after releasing `mutex`, so this might
+    // wait, but not for long.
+    consumeWakeup(*waiter->wakeup);
+    waiter->isPoked = false;
+    return true;
+}
+
+template <typename OBJECT>
+void MpmcState<OBJECT>::unpark(Side              side,
+                               Waiters::iterator waiter,
+                               Waiters&          removed) {
+    ThreadWakeup* toWake = 0;
+    CHAN_WITH_LOCK(mutex) {
+        removed.splice(removed.end(), waiters[side], waiter);
+        __atomic_fetch_sub(&numParked[side], 1, __ATOMIC_RELAXED);
+
+        if (waiter->isPoked) {
+            consumeWakeup(*waiter->wakeup);
+            waiter->isPoked = false;
+            if (isReady(side)) {
+                toWake = pokeFirstUnpoked(side);
+            }
+        }
+    }
+
+    if (toWake) {
+        postWakeup(*toWake);
+    }
+}
+
+template <typename OBJECT>
+void MpmcState<OBJECT>::wake(Side side) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // Usually nobody is parked, and then this is only a read of a line that
+    // nobody has written to lately.
+    if (!__atomic_load_n(&numParked[side], __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    ThreadWakeup* toWake;
+    CHAN_WITH_LOCK(mutex) {
+        toWake = pokeFirstUnpoked(side);
+    }
+
+    if (toWake) {
+        postWakeup(*toWake);
+    }
+}
+
+}  // namespace chan
+
+#endif
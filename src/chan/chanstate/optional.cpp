@@ -0,0 +1 @@
+#include <chan/chanstate/optional.h>
@@ -0,0 +1,168 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_OPTIONAL
+#define INCLUDED_CHAN_CHANSTATE_OPTIONAL
+
+// This component provides `Optional`, storage for one `OBJECT` that might or
+// might not contain one.  It's what a `Chan` receives into when the received
+// object should be constructed in place, rather than assigned to an existing
+// object, e.g. because `OBJECT` has no default constructor:
+//
+//     chan::Optional<Order> order;
+//     orders.recv(&order);
+//     process(*order);
+//
+// Unlike C++17's `std::optional`, which it resembles, `Optional` lets the
+// object be constructed by a function that's given the address of the
+// storage (see `emplaceUsing`), which is how a `Chan` constructs an object
+// whose constructor arguments are known only to the sender.
+
+#include <cassert>
+#include <new>
+#if __cplusplus >= 201103
+#include <utility>  // std::forward, std::move
+#endif
+
+namespace chan {
+
+template <typename OBJECT>
+class Optional {
+#if __cplusplus >= 201103
+    alignas(OBJECT) unsigned char storage[sizeof(OBJECT)];
+#else
+    unsigned char storage[sizeof(OBJECT)]
+        __attribute__((aligned(__alignof__(OBJECT))));
+#endif
+    bool isEngaged;
+
+    OBJECT* address() {
+        return static_cast<OBJECT*>(static_cast<void*>(storage));
+    }
+
+    const OBJECT* address() const {
+        return static_cast<const OBJECT*>(static_cast<const void*>(storage));
+    }
+
+  public:
+    // Create an empty `Optional`.
+    Optional()
+    : isEngaged(false) {
+    }
+
+    Optional(const Optional& other)
+    : isEngaged(false) {
+        if (other.isEngaged) {
+            emplace(*other);
+        }
+    }
+
+    Optional& operator=(const Optional& other) {
+        if (this != &other) {
+            reset();
+            if (other.isEngaged) {
+                emplace(*other);
+            }
+        }
+        return *this;
+    }
+
+#if __cplusplus >= 201103
+    Optional(Optional&& other)
+    : isEngaged(false) {
+        if (other.isEngaged) {
+            emplace(std::move(*other));
+        }
+    }
+
+    Optional& operator=(Optional&& other) {
+        if (this != &other) {
+            reset();
+            if (other.isEngaged) {
+                emplace(std::move(*other));
+            }
+        }
+        return *this;
+    }
+#endif
+
+    ~Optional() {
+        reset();
+    }
+
+    bool hasValue() const {
+        return isEngaged;
+    }
+
+    // Destroy the contained object, if any.
+    void reset() {
+        if (isEngaged) {
+            isEngaged = false;
+            address()->~OBJECT();
+        }
+    }
+
+    // Destroy the contained object, if any, and then construct one from the
+    // specified arguments, and return it.  If the constructor throws, this
+    // `Optional` is left empty.
+#if __cplusplus >= 201103
+    template <typename... ARGS>
+    OBJECT& emplace(ARGS&&... args) {
+        reset();
+        new (storage) OBJECT(std::forward<ARGS>(args)...);
+        isEngaged = true;
+        return *address();
+    }
+#else
+    OBJECT& emplace() {
+        reset();
+        new (storage) OBJECT();
+        isEngaged = true;
+        return *address();
+    }
+
+    template <typename ARG>
+    OBJECT& emplace(const ARG& arg) {
+        reset();
+        new (storage) OBJECT(arg);
+        isEngaged = true;
+        return *address();
+    }
+#endif
+
+    // Destroy the contained object, if any, and then call the specified
+    // `construct` with the address of uninitialized storage for an `OBJECT`,
+    // which `construct` must construct there, and return it.  If `construct`
+    // throws, it must not have constructed the object, and this `Optional` is
+    // left empty.
+    template <typename CONSTRUCTOR>
+    OBJECT& emplaceUsing(const CONSTRUCTOR& construct) {
+        reset();
+        construct(static_cast<void*>(storage));
+        isEngaged = true;
+        return *address();
+    }
+
+    // Return the contained object.  The behavior is undefined unless
+    // `hasValue()`.
+    OBJECT& operator*() {
+        assert(isEngaged);
+        return *address();
+    }
+
+    const OBJECT& operator*() const {
+        assert(isEngaged);
+        return *address();
+    }
+
+    OBJECT* operator->() {
+        assert(isEngaged);
+        return address();
+    }
+
+    const OBJECT* operator->() const {
+        assert(isEngaged);
+        return address();
+    }
+};
+
+}  // namespace chan
+
+#endif
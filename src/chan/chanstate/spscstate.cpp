@@ -0,0 +1 @@
+#include <chan/chanstate/spscstate.h>
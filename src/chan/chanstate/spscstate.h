@@ -0,0 +1,262 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_SPSCSTATE
+#define INCLUDED_CHAN_CHANSTATE_SPSCSTATE
+
+// This component provides `SpscState`, everything that the events of one
+// `SpscChan` share (see `chan/chan/spscchan.h`).  It's a bounded ring buffer
+// for exactly one producer thread and one consumer thread at a time, without
+// any mutex.  The producer owns `tail` and the consumer owns `head`, and each
+// side keeps a copy of the other's index, which it refreshes only when the
+// ring looks full or empty, respectively.  The fields written by each side
+// are padded apart so that the two threads don't contend for a cache line.
+//
+// A side that has to wait "parks" its `ThreadWakeup` in the state, and the
+// other side checks for it after each push or pop, but only posts a wakeup if
+// somebody is parked.  Parking and checking follow Dekker's pattern: each side
+// stores (its index, or its parked wakeup), issues a full fence, and then
+// loads what the other side stores, so at least one of them sees the other.
+// The wakeup is handed over with an atomic exchange, so that exactly one of
+// the parked side (by `unpark`) and the other side (by `wake`) takes it back
+// out.  If the other side takes it, it posts the wakeup, which the parked side
+// must then consume.
+
+#include <chan/files/threadwakeup.h>
+
+#include <algorithm>  // std::swap
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <new>
+#include <utility>  // std::move (if C++11)
+
+namespace chan {
+
+template <typename OBJECT>
+class SpscState {
+  public:
+    enum Side { SENDER, RECEIVER };
+
+  private:
+    // Padding is a whole (typical) cache line, so that whatever the alignment
+    // of this object, the fields on either side of it never share a line.
+    enum { CACHE_LINE = 64 };
+
+    // set on construction, and then only read
+    OBJECT* const     slots;     // one more than the capacity
+    const std::size_t numSlots;  // capacity + 1, so that full != empty
+    char              padding0[CACHE_LINE];
+
+    // written by the producer
+    std::size_t tail;        // where the next pushed object goes
+    std::size_t cachedHead;  // the producer's last look at `head`
+    char        padding1[CACHE_LINE];
+
+    // written by the consumer
+    std::size_t head;        // position of the oldest object
+    std::size_t cachedTail;  // the consumer's last look at `tail`
+    char        padding2[CACHE_LINE];
+
+    // the `ThreadWakeup` of whoever is waiting on each `Side`, or null.  These
+    // are read after every push and pop, but rarely written.
+    ThreadWakeup* parked[2];
+    char          padding3[CACHE_LINE];
+
+    SpscState(const SpscState&) /* = delete */;
+    SpscState& operator=(const SpscState&) /* = delete */;
+
+    std::size_t next(std::size_t position) const {
+        return position + 1 == numSlots ? 0 : position + 1;
+    }
+
+    // Return where the next pushed object goes, or null if the ring is full.
+    OBJECT* reserve();
+
+    // Make the object constructed at `tail` visible to the consumer.
+    void commit();
+
+  public:
+    // Create an empty `SpscState` able to hold the specified `capacity`
+    // objects.  The behavior is undefined unless `capacity` is positive.
+    explicit SpscState(std::size_t capacity);
+
+    // Destroy any objects remaining, and free the storage.
+    ~SpscState();
+
+    std::size_t capacity() const;
+
+    // Append a copy of the specified `object` and return `true`, or return
+    // `false` if the ring is full.  If the copy constructor throws, this
+    // object is unchanged.  Only the producer may call these.
+    bool tryPushCopy(const OBJECT& object);
+
+    // Append the value of the specified `object` and return `true`, or return
+    // `false` if the ring is full.  `object` is left in a moved-from state
+    // (C++11), or with the value of a default constructed `OBJECT` (C++98,
+    // where the two are swapped).
+    bool tryPushMove(OBJECT& object);
+
+    // Move (swap, in C++98) the oldest object into the specified
+    // `destination`, remove it, and return `true`, or return `false` if the
+    // ring is empty.  If the assignment throws, this object is unchanged.
+    // Only the consumer may call this.
+    bool tryPop(OBJECT* destination);
+
+    // Record the specified `wakeup` as waiting on the specified `side`, and
+    // then issue a full fence, after which the caller must check the ring
+    // again.  The behavior is undefined if `side` is already parked.
+    void park(Side side, ThreadWakeup& wakeup);
+
+    // Withdraw the wakeup parked on the specified `side`.  Return `true` if it
+    // was still there, or `false` if the other side already took it, in
+    // which case the other side has posted, or is about to post, a wakeup to
+    // it.  The behavior is undefined unless the caller parked on `side`.
+    bool unpark(Side side);
+
+    // Return whether the specified `side` is still parked.  Only the parked
+    // side may call this.
+    bool isParked(Side side) const;
+
+    // Issue a full fence, and then, if anybody is parked on the specified
+    // `side`, take their wakeup and post it.  Call this after each push (for
+    // `RECEIVER`) or pop (for `SENDER`).  If an error occurs, throw an
+    // exception.
+    void wake(Side side);
+};
+
+template <typename OBJECT>
+SpscState<OBJECT>::SpscState(std::size_t capacity)
+: slots(static_cast<OBJECT*>(::operator new((capacity + 1) *
+                                            sizeof(OBJECT))))
+, numSlots(capacity + 1)
+, tail()
+, cachedHead()
+, head()
+, cachedTail() {
+    assert(capacity > 0);
+    parked[SENDER]   = 0;
+    parked[RECEIVER] = 0;
+}
+
+template <typename OBJECT>
+SpscState<OBJECT>::~SpscState() {
+    // Both sides are gone by now, so there's no need for atomics.
+    for (std::size_t i = head; i != tail; i = next(i)) {
+        slots[i].~OBJECT();
+    }
+
+    ::operator delete(slots);
+}
+
+template <typename OBJECT>
+std::size_t SpscState<OBJECT>::capacity() const {
+    return numSlots - 1;
+}
+
+template <typename OBJECT>
+OBJECT* SpscState<OBJECT>::reserve() {
+    // Only the producer writes `tail`, so it can be read plainly.
+    const std::size_t nextTail = next(tail);
+    if (nextTail == cachedHead) {
+        cachedHead = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        if (nextTail == cachedHead) {
+            return 0;
+        }
+    }
+
+    return slots + tail;
+}
+
+template <typename OBJECT>
+void SpscState<OBJECT>::commit() {
+    __atomic_store_n(&tail, next(tail), __ATOMIC_RELEASE);
+}
+
+template <typename OBJECT>
+bool SpscState<OBJECT>::tryPushCopy(const OBJECT& object) {
+    OBJECT* const slot = reserve();
+    if (!slot) {
+        return false;
+    }
+
+    new (slot) OBJECT(object);
+    commit();
+    return true;
+}
+
+template <typename OBJECT>
+bool SpscState<OBJECT>::tryPushMove(OBJECT& object) {
+    OBJECT* const slot = reserve();
+    if (!slot) {
+        return false;
+    }
+
+#if __cplusplus >= 201103
+    new (slot) OBJECT(std::move(object));
+#else
+    new (slot) OBJECT();
+    using std::swap;
+    swap(*slot, object);
+#endif
+    commit();
+    return true;
+}
+
+template <typename OBJECT>
+bool SpscState<OBJECT>::tryPop(OBJECT* destination) {
+    assert(destination);
+
+    // Only the consumer writes `head`, so it can be read plainly.
+    if (head == cachedTail) {
+        cachedTail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+        if (head == cachedTail) {
+            return false;
+        }
+    }
+
+    OBJECT& oldest = slots[head];
+#if __cplusplus >= 201103
+    *destination = std::move(oldest);
+#else
+    using std::swap;
+    swap(*destination, oldest);
+#endif
+    oldest.~OBJECT();
+
+    __atomic_store_n(&head, next(head), __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename OBJECT>
+void SpscState<OBJECT>::park(Side side, ThreadWakeup& wakeup) {
+    assert(!isParked(side));
+    __atomic_store_n(&parked[side], &wakeup, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+template <typename OBJECT>
+bool SpscState<OBJECT>::unpark(Side side) {
+    return __atomic_exchange_n(&parked[side], 0, __ATOMIC_ACQ_REL) != 0;
+}
+
+template <typename OBJECT>
+bool SpscState<OBJECT>::isParked(Side side) const {
+    return __atomic_load_n(&parked[side], __ATOMIC_ACQUIRE) != 0;
+}
+
+template <typename OBJECT>
+void SpscState<OBJECT>::wake(Side side) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // Usually nobody is parked, and then this is only a read of a line that
+    // neither thread has written to lately.
+    if (!__atomic_load_n(&parked[side], __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    if (ThreadWakeup* const wakeup =
+            __atomic_exchange_n(&parked[side], 0, __ATOMIC_ACQ_REL)) {
+        postWakeup(*wakeup);
+    }
+}
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1 @@
+#include <chan/chanstate/waiterlist.h>
@@ -0,0 +1,131 @@
+#ifndef INCLUDED_CHAN_CHANSTATE_WAITERLIST
+#define INCLUDED_CHAN_CHANSTATE_WAITERLIST
+
+// This component provides `WaiterList`, an intrusive doubly linked list, and
+// `WaiterLink`, the base class of the nodes that can be linked into one.  A
+// `ChanState` keeps its waiting senders and receivers in `WaiterList`s, and
+// each node is the `ChanSender` or `ChanReceiver` inside of the waiting event
+// itself, so that joining or leaving the list neither allocates nor searches.
+//
+// A node must stay where it is for as long as it's linked.  Copying a node
+// copies none of its links: the copy is not linked, and assigning to a node
+// leaves its links as they were.  `WaiterList` is not thread-safe.
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+
+namespace chan {
+
+class WaiterLink {
+    template <typename NODE>
+    friend class WaiterList;
+
+    WaiterLink* prev;  // null if not linked
+    WaiterLink* next;
+
+  public:
+    WaiterLink()
+    : prev()
+    , next() {
+    }
+
+    WaiterLink(const WaiterLink&)
+    : prev()
+    , next() {
+    }
+
+    WaiterLink& operator=(const WaiterLink&) {
+        return *this;
+    }
+
+    bool isLinked() const {
+        return prev != 0;
+    }
+};
+
+template <typename NODE>
+class WaiterList {
+    WaiterLink  sentinel;  // `sentinel.next` is the front, `.prev` the back
+    std::size_t count;
+
+    WaiterList(const WaiterList&) /* = delete */;
+    WaiterList& operator=(const WaiterList&) /* = delete */;
+
+    static NODE* node(WaiterLink* link) {
+        return static_cast<NODE*>(link);
+    }
+
+  public:
+    WaiterList()
+    : sentinel()
+    , count() {
+        sentinel.prev = &sentinel;
+        sentinel.next = &sentinel;
+    }
+
+    ~WaiterList() {
+        assert(empty());
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    // The behavior is undefined if `empty()`.
+    NODE& front() {
+        assert(!empty());
+        return *node(sentinel.next);
+    }
+
+    const NODE& front() const {
+        assert(!empty());
+        return *node(sentinel.next);
+    }
+
+    // Return the first node, or the node after the specified `current`, or
+    // null if there isn't one.
+    NODE* first() {
+        return empty() ? 0 : node(sentinel.next);
+    }
+
+    NODE* after(NODE& current) {
+        assert(current.isLinked());
+        WaiterLink* const link = static_cast<WaiterLink&>(current).next;
+        return link == &sentinel ? 0 : node(link);
+    }
+
+    // Link the specified `waiter` at the back.  The behavior is undefined if
+    // `waiter` is already linked.
+    void push_back(NODE& waiter) {
+        WaiterLink& link = waiter;
+        assert(!link.isLinked());
+
+        link.prev           = sentinel.prev;
+        link.next           = &sentinel;
+        sentinel.prev->next = &link;
+        sentinel.prev       = &link;
+        ++count;
+    }
+
+    // Unlink the specified `waiter`.  The behavior is undefined unless
+    // `waiter` is linked into this list.
+    void remove(NODE& waiter) {
+        WaiterLink& link = waiter;
+        assert(link.isLinked());
+        assert(count);
+
+        link.prev->next = link.next;
+        link.next->prev = link.prev;
+        link.prev       = 0;
+        link.next       = 0;
+        --count;
+    }
+};
+
+}  // namespace chan
+
+#endif
@@ -13,25 +13,27 @@ const char* const messages[] = {
     "An error occurred, but no diagnostic message is available.",
 
     // CREATE_PIPE
-    "Unable to allocate a new pipe using POSIX pipe() in"
-    " chan::PipePool::take().",
+    "Unable to create the file on which a thread waits for channel protocol"
+    " messages (e.g. eventfd() or pipe()).",
 
     // GET_FILE_FLAGS
-    "Unable to get file's flags in order to later set it to nonblocking.",
+    "Unable to get a file's type or flags in order to read or write it"
+    " without blocking.",
 
     // SET_FILE_NONBLOCKING
     "Unable to set a file to non-blocking.",
 
     // DRAIN_PIPE
-    "Unable to read remaining data (if any) from pipe buffer in"
-    " chan::PipePool::giveBack.",
+    // No longer reported, since channel protocol messages no longer leave
+    // data behind in pipes.
+    "Unable to read remaining data (if any) from a pipe buffer.",
 
     // RESTORE_FILE_FLAGS
     "Unable to restore a file's flags after previously having set the file to"
     " non-blocking.",
 
     // MUTEX_INIT
-    "Unable to initialize mutex in chan::MutexImpl constructor.",
+    "Unable to initialize mutex in chan::Mutex constructor.",
 
     // MUTEX_LOCK
     "Unable to lock mutex in chan::Mutex::lock().",
@@ -49,13 +51,16 @@ const char* const messages[] = {
     "Unable to read from a file.",
 
     // PROTOCOL_WRITE
-    "Unable to write a channel protocol message to a pipe.",
+    "Unable to wake up a thread in order to send it a channel protocol"
+    " message.",
 
     // PROTOCOL_READ
-    "Unable to read a channel protocol message from a pipe.",
+    "Unable to consume the wakeup that accompanied a channel protocol"
+    " message.",
 
-    // PROTOCOL_READ
-    "Encountered EOF when reading a channel protocol message from a pipe.",
+    // PROTOCOL_READ_EOF
+    "Encountered EOF when consuming the wakeup that accompanied a channel"
+    " protocol message.",
 
     // TRANSFER
     "An exception was thrown on the other end of a Chan on which `select` was"
@@ -67,7 +72,15 @@ const char* const messages[] = {
     " cleaning up as part of handling the exception.  Their messages follow.",
 
     // WRITE
-    "Unable to write to a file."
+    "Unable to write to a file.",
+
+    // CREATE_POLLER
+    "Unable to create an instance of the system IO multiplexing facility"
+    " (e.g. epoll_create1()).",
+
+    // WATCH_FILE
+    "Unable to add, modify, or remove a file in the system IO multiplexing"
+    " facility (e.g. epoll_ctl())."
 };
 
 }  // unnamed namespace
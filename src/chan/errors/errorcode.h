@@ -28,7 +28,9 @@ class ErrorCode {
         PROTOCOL_READ_EOF    = -15,
         TRANSFER             = -16,
         SELECT_UNWINDING     = -17,
-        WRITE                = -18
+        WRITE                = -18,
+        CREATE_POLLER        = -19,
+        WATCH_FILE           = -20
     };
 
   private:
@@ -1 +1,61 @@
 #include <chan/event/eventcontext.h>
+
+#include <sched.h>
+
+namespace chan {
+
+int SelectorFulfillment::awaitUnclaimed(unsigned generation) const {
+    // A claim lasts no longer than one call to an event's `file` or
+    // `fulfill`, which never waits for long, but the claimant might have been
+    // preempted, so after spinning for a while, yield the processor.
+    for (int spins = 0;; ++spins) {
+        const int current = fulfilledEventKey(generation);
+        if (current != CLAIMED) {
+            return current;
+        }
+
+        if (spins >= 100) {
+            sched_yield();
+        }
+    }
+}
+
+bool SelectorFulfillment::claim(unsigned generation) {
+    for (;;) {
+        if (awaitUnclaimed(generation) != FULFILLABLE) {
+            return false;
+        }
+
+        if (tryClaim(generation) == FULFILLABLE) {
+            return true;
+        }
+    }
+}
+
+void SelectorFulfillment::forbid(bool holdingClaim) {
+    if (holdingClaim) {
+        settle(UNFULFILLABLE);
+        return;
+    }
+
+    const unsigned generation =
+        generationOf(__atomic_load_n(&word, __ATOMIC_RELAXED));
+    for (;;) {
+        const int state = awaitUnclaimed(generation);
+        if (state >= 0 || state == UNFULFILLABLE) {
+            return;  // fulfilled, or forbidden already
+        }
+
+        uint64_t current = pack(generation, state);
+        if (__atomic_compare_exchange_n(&word,
+                                        &current,
+                                        pack(generation, UNFULFILLABLE),
+                                        false,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+}  // namespace chan
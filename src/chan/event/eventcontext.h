@@ -1,12 +1,11 @@
 #ifndef INCLUDED_CHAN_EVENT_EVENTCONTEXT
 #define INCLUDED_CHAN_EVENT_EVENTCONTEXT
 
-#include <chan/threading/mutex.h>
-#include <chan/threading/sharedptr.h>
-
 #include <cassert>
 #include <ostream>
 
+#include <stdint.h>  // uint64_t
+
 namespace chan {
 
 // `EventKey` identifies an event within a `select` invocation.  It's meant to
@@ -16,27 +15,141 @@ typedef int EventKey;
 // `SelectorFulfillment` is a means by which an event in one `select`
 // invocation can check or set the fulfillment of an event in a different
 // `select` invocation.
-struct SelectorFulfillment {
-    // Note that, by convention, `&mutex` (the address of the `mutex`) will be
-    // used to determine the locking order among two or more
-    // `SelectorFulfillment::mutex`.
-    Mutex mutex;
-
+//
+// Its state is one word, which changes only by atomic compare-and-swap.  In
+// order to fulfill an event, one must first `claim` the state, changing it
+// from `FULFILLABLE` to `CLAIMED`, and then either `fulfill` it with the key
+// of the event, or `release` it back to `FULFILLABLE`.  A `select` claims its
+// own `SelectorFulfillment` while it calls an event's `file` or `fulfill`,
+// and a visiting `Chan` event claims the sitter's (see
+// `chan/chanevents/fulfillmentclaim.h`).  Anyone else who wants to claim the
+// state meanwhile has to wait, but a claim is held only briefly, so they spin
+// rather than block, yielding the processor if the claim takes a while.  In
+// particular, a visitor fulfills both its own `select` and the sitter's
+// before transferring an object between them, however large the object.
+//
+// By convention, the address of a `SelectorFulfillment` determines the order
+// in which anybody claims two or more of them, so that no two claimants each
+// wait for the other.
+//
+// A `SelectorFulfillment` is reused from one selection to the next, and from
+// one `select` to the next (see `chan/select/fulfillmentpool.h`), and is
+// never deleted, so a visitor may look at one long after the selection that
+// it knew about is over.  Each selection has its own generation, which is
+// part of the same word as the state.  Everybody names the generation that
+// they know about, and a generation that isn't the current one is
+// `UNFULFILLABLE`.
+class SelectorFulfillment {
+  public:
+    // The state is one of these, or else it's the `EventKey` of the fulfilled
+    // event, which is never negative.
     enum State {
-        FULFILLABLE,   // not fulfilled, and fulfillment is allowed
-        FULFILLED,     // has already been fulfilled
-        UNFULFILLABLE  // not fulfilled, but fulfillment is not allowed
+        FULFILLABLE   = -1,  // not fulfilled, and fulfillment is allowed
+        CLAIMED       = -2,  // about to be fulfilled or released
+        UNFULFILLABLE = -3   // not fulfilled, but fulfillment is not allowed
     };
 
-    State state;
+  private:
+    // the generation in the high 32 bits, and the state in the low 32 bits,
+    // only ever accessed atomically
+    uint64_t word;
+
+    SelectorFulfillment(const SelectorFulfillment&) /* = delete */;
+    SelectorFulfillment& operator=(const SelectorFulfillment&) /* = delete */;
 
-    // key of the fulfilled event; valid only if `state == FULFILLED`
-    EventKey fulfilledEventKey;
+    static uint64_t pack(unsigned generation, int state) {
+        return uint64_t(generation) << 32 | unsigned(state);
+    }
+
+    static unsigned generationOf(uint64_t word) {
+        return unsigned(word >> 32);
+    }
 
+    static int stateOf(uint64_t word) {
+        return int(unsigned(word));
+    }
+
+    // Change the state, keeping the generation.  The behavior is undefined
+    // unless the caller holds the claim.
+    void settle(int state) {
+        const uint64_t claimed = __atomic_load_n(&word, __ATOMIC_RELAXED);
+        assert(stateOf(claimed) == CLAIMED);
+        __atomic_store_n(
+            &word, pack(generationOf(claimed), state), __ATOMIC_RELEASE);
+    }
+
+    // Return the state of the specified `generation` once nobody has a claim
+    // on it.
+    int awaitUnclaimed(unsigned generation) const;
+
+  public:
     SelectorFulfillment()
-    : mutex()
-    , state(FULFILLABLE)
-    , fulfilledEventKey(-1) {
+    : word(pack(0, UNFULFILLABLE)) {
+    }
+
+    // Begin a new selection, making this object `FULFILLABLE`, and return the
+    // selection's generation.  The behavior is undefined if anybody has a
+    // claim on this object.
+    unsigned renew() {
+        const unsigned generation =
+            generationOf(__atomic_load_n(&word, __ATOMIC_RELAXED)) + 1;
+        __atomic_store_n(
+            &word, pack(generation, FULFILLABLE), __ATOMIC_RELEASE);
+        return generation;
+    }
+
+    // Wait until nobody else has a claim on the specified `generation` of
+    // this object, and then claim it if it's `FULFILLABLE`.  Return whether it
+    // was claimed.  If not, then it's `UNFULFILLABLE` or fulfilled, and will
+    // stay that way.
+    bool claim(unsigned generation);
+
+    // Claim the specified `generation` of this object if it's `FULFILLABLE`,
+    // without waiting.  Return the state that it had, which is `FULFILLABLE`
+    // if it was claimed.
+    int tryClaim(unsigned generation) {
+        uint64_t current = pack(generation, FULFILLABLE);
+        if (__atomic_compare_exchange_n(&word,
+                                        &current,
+                                        pack(generation, CLAIMED),
+                                        false,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE)) {
+            return FULFILLABLE;
+        }
+
+        return generationOf(current) == generation ? stateOf(current)
+                                                   : int(UNFULFILLABLE);
+    }
+
+    // Make this object `FULFILLABLE` again.  The behavior is undefined unless
+    // the caller holds the claim.
+    void release() {
+        settle(FULFILLABLE);
+    }
+
+    // Mark the event having the specified `key` as the fulfilled one.  The
+    // behavior is undefined unless the caller holds the claim.
+    void fulfill(EventKey key) {
+        assert(key >= 0);
+        settle(key);
+    }
+
+    // Make the current generation of this object `UNFULFILLABLE`, unless it
+    // was fulfilled, in which case it stays that way, so that the fulfilled
+    // event can still tell that it was, and finish up with whoever fulfilled
+    // it.  If the specified `holdingClaim` is `false`, first wait until nobody
+    // has a claim on this object.  The behavior is undefined if `holdingClaim`
+    // is `true` but the caller doesn't hold the claim.
+    void forbid(bool holdingClaim);
+
+    // Return the key of the fulfilled event of the specified `generation`, or
+    // a negative `State` if none has been fulfilled.  If the result is a key
+    // or `UNFULFILLABLE`, then it will not change.
+    EventKey fulfilledEventKey(unsigned generation) const {
+        const uint64_t current = __atomic_load_n(&word, __ATOMIC_ACQUIRE);
+        return generationOf(current) == generation ? stateOf(current)
+                                                   : int(UNFULFILLABLE);
     }
 };
 
@@ -44,25 +157,32 @@ struct SelectorFulfillment {
 // passed an `EventContext` as an argument to the event's `file` method.  The
 // `eventKey` within the `EventContext` refers to the event to whom's `file`
 // method was passed the `EventContext` (i.e. "this is your key").  The
-// `fulfillment` within the `EventContext` is a pointer to state common among
-// all events within that invocation of `select`.  This way, `Chan`-related
-// events in different `select` invocations can share their `EventContext` in
-// order to allow an event in one `select` invocation to fulfill an event in a
-// different `select` invocation.
+// `fulfillment` and `generation` within the `EventContext` refer to state
+// common among all events within that invocation of `select`.  This way,
+// `Chan`-related events in different `select` invocations can share their
+// `EventContext` in order to allow an event in one `select` invocation to
+// fulfill an event in a different `select` invocation.  An `EventContext` may
+// be copied freely, and outlive its `select`, since a `SelectorFulfillment` is
+// never deleted.
 struct EventContext {
-    SharedPtr<SelectorFulfillment> fulfillment;
+    SelectorFulfillment* fulfillment;
+    // the selection to which this `EventContext` belongs
+    unsigned generation;
     // key of the event to which this `EventContext` was originally given
     EventKey eventKey;
 
-    EventContext(const SharedPtr<SelectorFulfillment>& fulfillment,
-                 EventKey                              eventKey)
+    EventContext(SelectorFulfillment* fulfillment,
+                 unsigned             generation,
+                 EventKey             eventKey)
     : fulfillment(fulfillment)
+    , generation(generation)
     , eventKey(eventKey) {
         assert(fulfillment);
     }
 
     EventContext()
     : fulfillment()
+    , generation()
     , eventKey(-1) {
     }
 };
@@ -70,7 +190,8 @@ struct EventContext {
 inline std::ostream& operator<<(std::ostream&       stream,
                                 const EventContext& context) {
     return stream << "[eventKey=" << context.eventKey
-                  << " fulfillment=" << context.fulfillment.get() << "]";
+                  << " fulfillment=" << context.fulfillment
+                  << " generation=" << context.generation << "]";
 }
 
 }  // namespace chan
@@ -3,8 +3,6 @@
 #include <chan/fileevents/readevent.h>
 
 #include <errno.h>
-#include <fcntl.h>
-#include <unistd.h>
 
 namespace chan {
 
@@ -12,7 +10,7 @@ int ReadFunc::operator()(char* destination, int numBytes) const {
     int bytesWritten = 0;
 
     while (bytesWritten < numBytes) {
-        const int rc = ::read(fd, destination, numBytes - bytesWritten);
+        const long rc = file->read(destination, numBytes - bytesWritten);
         if (rc == -1) {
             switch (const int error = errno) {
                 case EINTR:
@@ -35,6 +35,7 @@
 #include <chan/files/filenonblockingguard.h>
 #include <chan/select/lasterror.h>
 #include <chan/select/select.h>
+#include <chan/select/selectone.h>
 
 #include <cassert>
 
@@ -64,21 +65,23 @@ class ReadResult {
 };
 
 class ReadFunc {
-    int fd;
+    FileNonblockingGuard* file;
 
   public:
-    explicit ReadFunc(int fd)
-    : fd(fd) {
+    explicit ReadFunc(FileNonblockingGuard& file)
+    : file(&file) {
     }
 
-    // Read at most `numBytes` from `fd` and copy them into `fd`.  Return the
-    // number of bytes read.  Throw an exception if an error occurs.
+    // Read at most `numBytes` from `file` and copy them into `destination`.
+    // Return the number of bytes read.  Throw an exception if an error
+    // occurs.
     int operator()(char* destination, int numBytes) const;
 };
 
 template <typename HANDLER>
 class ReadEvent {
-    int fd;
+    int                          fd;
+    FileNonblockingGuard::Method ioMethod;
 
   protected:
     HANDLER      handler;
@@ -87,12 +90,14 @@ class ReadEvent {
   public:
     ReadEvent(int fd, HANDLER handler)
     : fd(fd)
+    , ioMethod(FileNonblockingGuard::UNKNOWN)
     , handler(handler)
     , selectOnDestroy(true) {
     }
 
     ReadEvent(const ReadEvent& other)
     : fd(other.fd)
+    , ioMethod(other.ioMethod)
     , handler(other.handler)
     , selectOnDestroy(other.selectOnDestroy) {
         // If `other` thought that it was responsible for calling `select` when
@@ -102,7 +107,7 @@ class ReadEvent {
 
     ~ReadEvent() CHAN_THROWS {
         if (selectOnDestroy && !uncaughtExceptions()) {
-            if (select(*this)) {
+            if (selectOne(EventRef(*this))) {
                 throw lastError();
             }
         }
@@ -122,11 +127,10 @@ class ReadEvent {
     }
 
     IoEvent fulfill(IoEvent event) {
-        // Make sure that the file is in non-blocking mode, but restore
-        // whatever flags it had previously once we're done with it.
-        FileNonblockingGuard guard(fd);
+        // Read without blocking, but leave the file's flags as they were.
+        FileNonblockingGuard guard(fd, ioMethod);
 
-        const ReadResult result = handler(ReadFunc(fd));
+        const ReadResult result = handler(ReadFunc(guard));
         if (result == ReadResult::FULFILLED) {
             event.fulfilled = true;
         }
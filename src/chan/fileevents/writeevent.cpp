@@ -4,7 +4,6 @@
 #include <chan/fileevents/writeevent.h>
 
 #include <errno.h>
-#include <unistd.h>
 
 namespace chan {
 
@@ -19,7 +18,8 @@ int WriteFunc::operator()(const char* source, int numBytes) const {
 
     int numWritten = 0;
     while (numWritten < numBytes) {
-        const ssize_t rc = ::write(fd, source + numWritten, numBytes - numWritten);
+        const long rc =
+            file->write(source + numWritten, numBytes - numWritten);
         if (rc != -1) {
             // successful write of `rc` bytes
             numWritten += rc;
@@ -12,6 +12,7 @@
 #include <chan/files/filenonblockingguard.h>
 #include <chan/select/lasterror.h>
 #include <chan/select/select.h>
+#include <chan/select/selectone.h>
 #include <chan/time/duration.h>
 #include <chan/time/timepoint.h>
 
@@ -45,23 +46,24 @@ class WriteResult {
 };
 
 class WriteFunc {
-    int fd;
+    FileNonblockingGuard* file;
 
   public:
-    explicit WriteFunc(int fd)
-    : fd(fd) {
+    explicit WriteFunc(FileNonblockingGuard& file)
+    : file(&file) {
     }
 
-    // Write at most `numBytes` to `fd` from `source`.  Return the number of
+    // Write at most `numBytes` to `file` from `source`.  Return the number of
     // bytes written. Throw an exception if an error occurs.
     int operator()(const char* source, int numBytes) const;
 };
 
 template <typename HANDLER>
 class WriteEvent {
-    int      fd;
-    Duration brokenPipeTimeout;
-    Duration handlerWaitTimeout;
+    int                          fd;
+    FileNonblockingGuard::Method ioMethod;
+    Duration                     brokenPipeTimeout;
+    Duration                     handlerWaitTimeout;
 
   protected:
     HANDLER      handler;
@@ -70,6 +72,7 @@ class WriteEvent {
   public:
     WriteEvent(int fd, HANDLER handler)
     : fd(fd)
+    , ioMethod(FileNonblockingGuard::UNKNOWN)
     , handler(handler)
     , selectOnDestroy(true) {
         resetBrokenPipeTimeout();
@@ -78,6 +81,7 @@ class WriteEvent {
 
     WriteEvent(const WriteEvent& other)
     : fd(other.fd)
+    , ioMethod(other.ioMethod)
     , brokenPipeTimeout(other.brokenPipeTimeout)
     , handlerWaitTimeout(other.handlerWaitTimeout)
     , handler(other.handler)
@@ -89,7 +93,7 @@ class WriteEvent {
 
     ~WriteEvent() CHAN_THROWS {
         if (selectOnDestroy && !uncaughtExceptions()) {
-            if (select(*this)) {
+            if (selectOne(EventRef(*this))) {
                 throw lastError();
             }
         }
@@ -141,11 +145,10 @@ class WriteEvent {
         // However, if the `fd` is writeable, then we can reset the timeout.
         resetBrokenPipeTimeout();
 
-        // Make sure that the file is in non-blocking mode, but restore
-        // whatever flags it had previously once we're done with it.
-        FileNonblockingGuard guard(fd);
+        // Write without blocking, but leave the file's flags as they were.
+        FileNonblockingGuard guard(fd, ioMethod);
 
-        switch (const WriteResult rc = handler(WriteFunc(fd))) {
+        switch (const WriteResult rc = handler(WriteFunc(guard))) {
             case WriteResult::FULFILLED:
                 event.fulfilled = true;
                 return event;
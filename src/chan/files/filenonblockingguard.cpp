@@ -4,29 +4,126 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cassert>
 
 namespace chan {
+namespace {
+
+// An older kernel rejects `RWF_NOWAIT`, or `preadv2` and `pwritev2`
+// altogether, with one of these errors, in which case fall back to the flags.
+bool isNowaitUnsupported(int error) {
+    return error == EOPNOTSUPP || error == ENOSYS || error == EINVAL;
+}
+
+}  // unnamed namespace
+
+FileNonblockingGuard::~FileNonblockingGuard() CHAN_THROWS {
+    if (isFlagsChanged && ::fcntl(fd, F_SETFL, flags) == -1) {
+        throw Error(ErrorCode::RESTORE_FILE_FLAGS, errno);
+    }
+}
+
+FileNonblockingGuard::Method FileNonblockingGuard::methodToUse() {
+    if (method != UNKNOWN) {
+        return method;
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) == -1) {
+        throw Error(ErrorCode::GET_FILE_FLAGS, errno);
+    }
+
+#ifdef MSG_DONTWAIT
+    if (S_ISSOCK(status.st_mode)) {
+        return method = SOCKET;
+    }
+#endif
 
-int FileNonblockingGuard::getFlags(int file) {
-    const int flags = ::fcntl(file, F_GETFL);
+#ifdef RWF_NOWAIT
+    if (S_ISFIFO(status.st_mode)) {
+        return method = PIPE;
+    }
+#endif
+
+    return method = FILE_FLAGS;
+}
+
+void FileNonblockingGuard::setNonblocking() {
+    if (isFlagsChecked) {
+        return;
+    }
 
+    flags = ::fcntl(fd, F_GETFL);
     if (flags == -1) {
         throw Error(ErrorCode::GET_FILE_FLAGS, errno);
     }
+    isFlagsChecked = true;
+
+    if (flags & O_NONBLOCK) {
+        return;
+    }
 
-    return flags;
+    if (::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw Error(ErrorCode::SET_FILE_NONBLOCKING, errno);
+    }
+    isFlagsChanged = true;
 }
 
-void FileNonblockingGuard::restoreFlags(int file, int flags) {
-    if (::fcntl(file, F_SETFL, flags) == -1) {
-        throw Error(ErrorCode::RESTORE_FILE_FLAGS, errno);
+long FileNonblockingGuard::read(char* destination, std::size_t numBytes) {
+    switch (methodToUse()) {
+#ifdef MSG_DONTWAIT
+        case SOCKET:
+            return ::recv(fd, destination, numBytes, MSG_DONTWAIT);
+#endif
+#ifdef RWF_NOWAIT
+        case PIPE: {
+            iovec         buffer = { destination, numBytes };
+            const ssize_t rc     = ::preadv2(fd, &buffer, 1, -1, RWF_NOWAIT);
+            if (rc != -1 || !isNowaitUnsupported(errno)) {
+                return rc;
+            }
+
+            method = FILE_FLAGS;
+            break;
+        }
+#endif
+        default:
+            assert(method == FILE_FLAGS);
     }
+
+    setNonblocking();
+    return ::read(fd, destination, numBytes);
 }
 
-void FileNonblockingGuard::setNonblocking(int file, int flags) {
-    if (::fcntl(file, F_SETFL, flags | O_NONBLOCK) == -1) {
-        throw Error(ErrorCode::SET_FILE_NONBLOCKING, errno);
+long FileNonblockingGuard::write(const char* source, std::size_t numBytes) {
+    switch (methodToUse()) {
+#ifdef MSG_DONTWAIT
+        case SOCKET:
+            return ::send(fd, source, numBytes, MSG_DONTWAIT);
+#endif
+#ifdef RWF_NOWAIT
+        case PIPE: {
+            iovec buffer = { const_cast<char*>(source), numBytes };
+            const ssize_t rc = ::pwritev2(fd, &buffer, 1, -1, RWF_NOWAIT);
+            if (rc != -1 || !isNowaitUnsupported(errno)) {
+                return rc;
+            }
+
+            method = FILE_FLAGS;
+            break;
+        }
+#endif
+        default:
+            assert(method == FILE_FLAGS);
     }
+
+    setNonblocking();
+    return ::write(fd, source, numBytes);
 }
 
-}  // namespace chan
\ No newline at end of file
+}  // namespace chan
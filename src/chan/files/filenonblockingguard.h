@@ -1,26 +1,76 @@
 #ifndef INCLUDED_CHAN_FILES_FILENONBLOCKINGGUARD
 #define INCLUDED_CHAN_FILES_FILENONBLOCKINGGUARD
 
+// `FileNonblockingGuard` reads from and writes to a file without blocking,
+// whether or not the file is in non-blocking mode, and leaves the file's
+// flags as it found them.
+//
+// Changing the flags costs two `fcntl` calls, plus one to find out what they
+// were, so the guard avoids that when it can.  A socket is read and written
+// using `recv` and `send` with `MSG_DONTWAIT`, and, on Linux, a pipe using
+// `preadv2` and `pwritev2` with `RWF_NOWAIT`, so that each costs only the one
+// system call.  Any other file is put in non-blocking mode the first time the
+// guard reads or writes, unless it's in non-blocking mode already, and its
+// flags are restored when the guard is destroyed.
+//
+// Which of those methods applies is found out using `fstat` the first time
+// that it's needed, and is stored in a `FileNonblockingGuard::Method` kept by
+// the caller, so that later guards for the same file don't need to find out
+// again.
+
+#include <chan/errors/noexcept.h>
+
+#include <cstddef>  // std::size_t
+
 namespace chan {
 
 class FileNonblockingGuard {
-    int fd;
-    int flags;
+  public:
+    enum Method {
+        UNKNOWN,    // not yet found out
+        SOCKET,     // `MSG_DONTWAIT`
+        PIPE,       // `RWF_NOWAIT`
+        FILE_FLAGS  // `O_NONBLOCK`, set temporarily if need be
+    };
+
+  private:
+    int     fd;
+    Method& method;
+    int     flags;          // the file's original flags, if `isFlagsChecked`
+    bool    isFlagsChecked;
+    bool    isFlagsChanged;
 
-    static int  getFlags(int fd);
-    static void restoreFlags(int fd, int flags);
-    static void setNonblocking(int fd, int flags);
+    FileNonblockingGuard(const FileNonblockingGuard&) /* = delete */;
+    FileNonblockingGuard& operator=(const FileNonblockingGuard&)
+        /* = delete */;
+
+    // Return `method`, having found it out if it's `UNKNOWN`.
+    Method methodToUse();
+
+    // Put `fd` into non-blocking mode unless it is already.
+    void setNonblocking();
 
   public:
-    explicit FileNonblockingGuard(int fd)
+    // Create a guard for the specified file descriptor `fd`, using the
+    // specified `method`, which may be `UNKNOWN`, and which is updated when
+    // found out.  This doesn't do anything to the file.
+    FileNonblockingGuard(int fd, Method& method)
     : fd(fd)
-    , flags(getFlags(fd)) {
-        setNonblocking(fd, flags);
+    , method(method)
+    , flags()
+    , isFlagsChecked(false)
+    , isFlagsChanged(false) {
     }
 
-    ~FileNonblockingGuard() {
-        restoreFlags(fd, flags);
-    }
+    ~FileNonblockingGuard() CHAN_THROWS;
+
+    // Read up to the specified `numBytes` into the specified `destination`,
+    // or write up to `numBytes` from the specified `source`, without
+    // blocking.  Return and set `errno` as `::read` and `::write` would for
+    // a file in non-blocking mode.  Throw an exception if the file's flags
+    // can't be examined or changed.
+    long read(char* destination, std::size_t numBytes);
+    long write(const char* source, std::size_t numBytes);
 };
 
 }  // namespace chan
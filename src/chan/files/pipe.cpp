@@ -1 +0,0 @@
-#include <chan/files/pipe.h>
@@ -0,0 +1,343 @@
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/files/threadwakeup.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>  // uint64_t
+#include <unistd.h>  // close, pipe, read, write
+
+#ifdef CHAN_HAS_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
+#ifdef CHAN_HAS_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#include <cassert>
+
+namespace chan {
+namespace {
+
+// `ThreadWakeup::state` is the count of pending wakeups, in multiples of
+// `ONE_WAKEUP`, plus the following flags.  Only the owning thread sets
+// `WAITING` or changes `POLLING`.  Whoever posts a wakeup clears `WAITING`,
+// and then wakes the owner if it was set.
+enum {
+    WAITING    = 1,  // the owner is, or is about to be, in a `futex` wait
+    POLLING    = 2,  // each wakeup is also written to `wakeFile`
+    ONE_WAKEUP = 4
+};
+
+// Without `futex`, there's no other way to wait, so `wakeFile` is always
+// written to.
+#ifdef CHAN_HAS_FUTEX
+const unsigned initialState = 0;
+#else
+const unsigned initialState = POLLING;
+#endif
+
+unsigned countOf(unsigned state) {
+    return state / ONE_WAKEUP;
+}
+
+unsigned load(const unsigned* state) {
+    return __atomic_load_n(state, __ATOMIC_ACQUIRE);
+}
+
+// Replace the specified `*state` with the specified `desired` value if it's
+// equal to the specified `*expected` value, and return `true`.  Otherwise,
+// load the current value into `*expected` and return `false`.
+bool exchange(unsigned* state, unsigned* expected, unsigned desired) {
+    return __atomic_compare_exchange_n(
+        state, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+// An `eventfd` is read and written eight bytes at a time, and in semaphore
+// mode each read decrements its count by one.  A pipe is read and written a
+// byte at a time, and each byte is one token.
+#ifdef CHAN_HAS_EVENTFD
+typedef uint64_t Token;
+#else
+typedef char Token;
+#endif
+
+void writeTokens(int file, unsigned howMany) {
+#ifdef CHAN_HAS_EVENTFD
+    const Token tokens[] = { howMany };
+    const unsigned numWrites = 1;
+#else
+    const Token tokens[] = { 1 };
+    const unsigned numWrites = howMany;
+#endif
+
+    for (unsigned i = 0; i < numWrites;) {
+        const int rc = ::write(file, tokens, sizeof tokens);
+        if (rc == -1) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+
+            throw Error(ErrorCode::PROTOCOL_WRITE, error);
+        }
+
+        assert(rc == sizeof tokens);
+        ++i;
+    }
+}
+
+void readToken(int file) {
+    Token token;
+    for (;;) {
+        const int rc = ::read(file, &token, sizeof token);
+        if (rc == -1) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+
+            throw Error(ErrorCode::PROTOCOL_READ, error);
+        }
+        else if (rc == 0) {
+            throw Error(ErrorCode::PROTOCOL_READ_EOF);
+        }
+
+        assert(rc == sizeof token);
+        return;
+    }
+}
+
+#ifdef CHAN_HAS_FUTEX
+// Set `WAITING` in the specified `wakeup`, whose state was most recently
+// observed to be the specified `observed`, and then wait, for no longer than
+// the optionally specified relative `timeout`, for the state to change.
+// Return zero if woken up, or otherwise the error reported by `futex` (e.g.
+// `EAGAIN` if the state had already changed).
+int park(ThreadWakeup& wakeup, unsigned observed, const timespec* timeout) {
+    if (!(observed & WAITING)) {
+        const unsigned waiting = observed | WAITING;
+        if (!exchange(&wakeup.state, &observed, waiting)) {
+            return EAGAIN;
+        }
+        observed = waiting;
+    }
+
+    if (::syscall(SYS_futex,
+                  &wakeup.state,
+                  FUTEX_WAIT_PRIVATE,
+                  observed,
+                  timeout,
+                  0,
+                  0) == 0) {
+        return 0;
+    }
+
+    return errno;
+}
+#endif
+
+// When a thread exits, its `ThreadWakeup` is kept for the next thread that
+// needs one, rather than being deleted, because a thread that posted a
+// wakeup to it might not yet have returned from waking up the exiting thread.
+// `current` caches the calling thread's `ThreadWakeup`, which is also stored
+// under `key` so that `recycle` is called.  Unlike `chan::lastError` (see
+// `chan/select/lasterror.cpp`), this can fail anyway, because creating the
+// files can fail.
+#if __cplusplus >= 201103
+thread_local
+#else
+__thread
+#endif
+    ThreadWakeup* current;
+
+struct RecycledWakeup : public ThreadWakeup {
+    RecycledWakeup* next;
+};
+
+pthread_mutex_t recycledMutex = PTHREAD_MUTEX_INITIALIZER;
+RecycledWakeup* recycled;
+
+pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t  key;
+int            keyError;  // nonzero if `key` couldn't be created
+
+void recycle(void* wakeupRaw) {
+    RecycledWakeup* const wakeup = static_cast<RecycledWakeup*>(wakeupRaw);
+    assert(countOf(load(&wakeup->state)) == 0);
+
+    ::pthread_mutex_lock(&recycledMutex);
+    wakeup->next = recycled;
+    recycled     = wakeup;
+    ::pthread_mutex_unlock(&recycledMutex);
+}
+
+void createKey() {
+    keyError = ::pthread_key_create(&key, &recycle);
+}
+
+void open(ThreadWakeup* wakeup) {
+#ifdef CHAN_HAS_EVENTFD
+    const int file = ::eventfd(0, EFD_SEMAPHORE | EFD_CLOEXEC);
+    if (file == -1) {
+        throw Error(ErrorCode::CREATE_PIPE, errno);
+    }
+    wakeup->waitFile = file;
+    wakeup->wakeFile = file;
+#else
+    int files[2];
+    if (::pipe(files)) {
+        throw Error(ErrorCode::CREATE_PIPE, errno);
+    }
+    wakeup->waitFile = files[0];
+    wakeup->wakeFile = files[1];
+#endif
+}
+
+}  // unnamed namespace
+
+ThreadWakeup& threadWakeup() {
+    if (current) {
+        return *current;
+    }
+
+    ::pthread_once(&keyOnce, &createKey);
+    if (keyError) {
+        throw Error(ErrorCode::CREATE_PIPE, keyError);
+    }
+
+    ::pthread_mutex_lock(&recycledMutex);
+    RecycledWakeup* wakeup = recycled;
+    if (wakeup) {
+        recycled = wakeup->next;
+    }
+    ::pthread_mutex_unlock(&recycledMutex);
+
+    if (!wakeup) {
+        wakeup = new RecycledWakeup;
+        try {
+            open(wakeup);
+        }
+        catch (...) {
+            delete wakeup;
+            throw;
+        }
+    }
+
+    // A `WAITING` flag might remain from the previous owner.
+    __atomic_store_n(&wakeup->state, initialState, __ATOMIC_RELEASE);
+
+    if (const int error = ::pthread_setspecific(key, wakeup)) {
+        recycle(wakeup);
+        throw Error(ErrorCode::CREATE_PIPE, error);
+    }
+
+    current = wakeup;
+    return *wakeup;
+}
+
+void postWakeup(ThreadWakeup& wakeup) {
+    unsigned before = load(&wakeup.state);
+    while (!exchange(
+        &wakeup.state, &before, (before + ONE_WAKEUP) & ~unsigned(WAITING))) {
+    }
+
+    if (before & POLLING) {
+        writeTokens(wakeup.wakeFile, 1);
+    }
+
+#ifdef CHAN_HAS_FUTEX
+    if (before & WAITING) {
+        // This can't fail in any way that matters.  If the owner has already
+        // moved on, then it treats the wakeup as spurious.
+        ::syscall(SYS_futex, &wakeup.state, FUTEX_WAKE_PRIVATE, 1, 0, 0, 0);
+    }
+#endif
+}
+
+void consumeWakeup(ThreadWakeup& wakeup) {
+    unsigned state = load(&wakeup.state);
+
+    if (state & POLLING) {
+        // Each wakeup has a token in the file, written after the count was
+        // incremented, so once a token is read, the count is nonzero.
+        readToken(wakeup.waitFile);
+        __atomic_fetch_sub(&wakeup.state, ONE_WAKEUP, __ATOMIC_ACQ_REL);
+        return;
+    }
+
+#ifdef CHAN_HAS_FUTEX
+    for (;;) {
+        if (countOf(state)) {
+            if (exchange(&wakeup.state, &state, state - ONE_WAKEUP)) {
+                return;
+            }
+            continue;
+        }
+
+        const int error = park(wakeup, state, 0);
+        if (error && error != EAGAIN && error != EINTR) {
+            throw Error(ErrorCode::PROTOCOL_READ, error);
+        }
+        state = load(&wakeup.state);
+    }
+#else
+    assert(!"without futex, a ThreadWakeup is always polled");
+#endif
+}
+
+void startPollingWakeup(ThreadWakeup& wakeup) {
+#ifdef CHAN_HAS_FUTEX
+    // Wakeups posted before now weren't written to the file, so write them
+    // now.  Those posted from now on will write themselves.
+    const unsigned before =
+        __atomic_fetch_or(&wakeup.state, POLLING, __ATOMIC_ACQ_REL);
+    if (!(before & POLLING) && countOf(before)) {
+        writeTokens(wakeup.wakeFile, countOf(before));
+    }
+#else
+    (void)wakeup;
+#endif
+}
+
+void stopPollingWakeup(ThreadWakeup& wakeup) {
+#ifdef CHAN_HAS_FUTEX
+    assert(countOf(load(&wakeup.state)) == 0);
+    __atomic_fetch_and(&wakeup.state, ~unsigned(POLLING), __ATOMIC_ACQ_REL);
+#else
+    (void)wakeup;
+#endif
+}
+
+#ifdef CHAN_HAS_FUTEX
+bool awaitWakeup(ThreadWakeup& wakeup, const timespec* timeout) {
+    unsigned state = load(&wakeup.state);
+    while (!countOf(state)) {
+        // `futex` measures `timeout` against the monotonic clock, as does
+        // `chan::now`.  If woken up without a wakeup (e.g. by a poster that
+        // was late in waking the previous owner), return anyway, as `::poll`
+        // would after a signal, so that the caller recalculates `timeout`.
+        const int error = park(wakeup, state, timeout);
+        state           = load(&wakeup.state);
+        if (error == EAGAIN) {
+            continue;
+        }
+        else if (error && error != EINTR && error != ETIMEDOUT) {
+            throw Error(ErrorCode::POLL, error);
+        }
+        break;
+    }
+
+    if (state & WAITING) {
+        __atomic_fetch_and(
+            &wakeup.state, ~unsigned(WAITING), __ATOMIC_ACQ_REL);
+    }
+
+    return countOf(state) != 0;
+}
+#endif
+
+}  // namespace chan
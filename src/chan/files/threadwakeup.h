@@ -0,0 +1,88 @@
+#ifndef INCLUDED_CHAN_FILES_THREADWAKEUP
+#define INCLUDED_CHAN_FILES_THREADWAKEUP
+
+// A `ThreadWakeup` is how other threads tell a thread, waiting within
+// `select`, that something happened on a channel.  A thread is only ever
+// inside of one `select` at a time, so each thread needs only one
+// `ThreadWakeup`, no matter how many channels it uses.  It's created the first
+// time the thread needs it, and is recycled when the thread exits.
+//
+// A `ThreadWakeup` counts wakeups.  `postWakeup` increments the count, and
+// `consumeWakeup` decrements it, so a thread that consumes exactly the
+// wakeups that were posted to it never sees a stale one.
+//
+// The count is kept in memory.  A thread whose `select` involves nothing but
+// channels (and maybe timeouts) waits for the count to become nonzero using
+// `awaitWakeup`, which on Linux is a `futex` wait, so that a wakeup costs one
+// system call on each side.  A thread whose `select` also involves other
+// files has to wait for them all at once using the system IO multiplexing
+// facility, so it first calls `startPollingWakeup`, after which `waitFile` is
+// readable for as long as the count is nonzero, and then calls
+// `stopPollingWakeup` once the `select` is over.
+//
+// On Linux, `waitFile` and `wakeFile` are the same `eventfd` in semaphore
+// mode.  Elsewhere, they are the two ends of a pipe.  Without `futex` (i.e.
+// other than on Linux, or if `CHAN_NO_FUTEX` is defined), `awaitWakeup` is
+// not available, and a `ThreadWakeup` is always being polled.
+
+#if defined(__linux__) && !defined(CHAN_NO_EVENTFD)
+#define CHAN_HAS_EVENTFD 1
+#endif
+
+#if defined(__linux__) && !defined(CHAN_NO_FUTEX)
+#define CHAN_HAS_FUTEX 1
+#endif
+
+struct timespec;
+
+namespace chan {
+
+struct ThreadWakeup {
+    int waitFile;  // readable while polled and wakeups are pending
+    int wakeFile;  // written to in order to post a wakeup while polled
+
+    // the count of pending wakeups, together with flags indicating whether
+    // the owning thread is waiting on it or polling `waitFile`.  It's only
+    // accessed atomically, and it's the word on which `awaitWakeup` waits.
+    unsigned state;
+};
+
+// Return the calling thread's `ThreadWakeup`, creating it if necessary.  If an
+// error occurs, throw an exception.
+ThreadWakeup& threadWakeup();
+
+// Increment the count of pending wakeups of the specified `wakeup`, which may
+// belong to any thread, and wake up its thread if the thread is waiting.  If
+// an error occurs, throw an exception.
+void postWakeup(ThreadWakeup& wakeup);
+
+// Decrement the count of pending wakeups of the specified `wakeup`, first
+// waiting for the count to be nonzero if necessary.  The behavior is
+// undefined unless `wakeup` belongs to the calling thread, and unless a
+// wakeup has been or will be posted to it.  If an error occurs, throw an
+// exception.
+void consumeWakeup(ThreadWakeup& wakeup);
+
+// Make the `waitFile` of the specified `wakeup` readable for as long as its
+// count of pending wakeups is nonzero.  The behavior is undefined unless
+// `wakeup` belongs to the calling thread.  If an error occurs, throw an
+// exception.
+void startPollingWakeup(ThreadWakeup& wakeup);
+
+// Undo `startPollingWakeup` on the specified `wakeup`.  The behavior is
+// undefined unless `wakeup` belongs to the calling thread and has no pending
+// wakeups.
+void stopPollingWakeup(ThreadWakeup& wakeup);
+
+#ifdef CHAN_HAS_FUTEX
+// Block until the count of pending wakeups of the specified `wakeup` is
+// nonzero, or until the optionally specified relative `timeout` elapses, or
+// until a signal is caught.  Return whether the count is nonzero.  Don't
+// consume anything.  The behavior is undefined unless `wakeup` belongs to the
+// calling thread.  If an error occurs, throw an exception.
+bool awaitWakeup(ThreadWakeup& wakeup, const timespec* timeout);
+#endif
+
+}  // namespace chan
+
+#endif
@@ -2,10 +2,14 @@
 #define INCLUDED_CHAN_SELECT
 
 #include <chan/select/lasterror.h>
+#include <chan/select/random.h>
 #include <chan/select/select.h>
+#include <chan/select/selectbackend.h>
+#include <chan/select/selectset.h>
 #include <chan/time/duration.h>
 #include <chan/time/timepoint.h>
 #include <chan/timeevents/deadline.h>
+#include <chan/timeevents/otherwise.h>
 #include <chan/timeevents/timeout.h>
 
 #endif
@@ -0,0 +1,398 @@
+#include <chan/select/epollpoller.h>
+
+#ifdef CHAN_HAS_EPOLL
+
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+
+// `epoll_pwait2` was added to glibc in version 2.35.
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#define CHAN_HAS_EPOLL_PWAIT2 1
+#endif
+
+namespace chan {
+namespace {
+
+unsigned toEpoll(short events) {
+    unsigned result = 0;
+    if (events & (POLLIN | POLLRDNORM | POLLRDBAND)) {
+        result |= EPOLLIN;
+    }
+    if (events & POLLPRI) {
+        result |= EPOLLPRI;
+    }
+    if (events & (POLLOUT | POLLWRNORM | POLLWRBAND)) {
+        result |= EPOLLOUT;
+    }
+    return result;
+}
+
+short fromEpoll(unsigned events) {
+    short result = 0;
+    if (events & EPOLLIN) {
+        result |= POLLIN | POLLRDNORM;
+    }
+    if (events & EPOLLPRI) {
+        result |= POLLPRI;
+    }
+    if (events & EPOLLOUT) {
+        result |= POLLOUT | POLLWRNORM;
+    }
+    if (events & EPOLLERR) {
+        result |= POLLERR;
+    }
+    if (events & EPOLLHUP) {
+        result |= POLLHUP;
+    }
+    return result;
+}
+
+// Return the subset of the specified `revents` that is relevant to a key
+// watching for the specified `events`.  Errors and hangups are always
+// relevant, as they are with `::poll`.
+short relevant(short revents, short events) {
+    return revents & (events | POLLERR | POLLHUP | POLLNVAL);
+}
+
+// Call `epoll_ctl` with the specified arguments, retrying if interrupted by a
+// signal.  Return zero on success or the `errno` value on failure.
+int control(int epollFd, int operation, int file, unsigned events) {
+    epoll_event event = epoll_event();
+    event.events      = events;
+    event.data.fd     = file;
+
+    for (;;) {
+        if (::epoll_ctl(epollFd, operation, file, &event) == 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return errno;
+        }
+    }
+}
+
+}  // unnamed namespace
+
+EpollPoller::EpollPoller()
+: epollFd(-1)
+, keys()
+, files()
+, numUnpollableKeys(0)
+, timerFd(-1)
+, timerArmed(false)
+, hasPwait2(true) {
+}
+
+EpollPoller::~EpollPoller() {
+    if (timerFd != -1) {
+        ::close(timerFd);
+    }
+    if (isOpen()) {
+        ::close(epollFd);
+    }
+}
+
+bool EpollPoller::reset(int numKeys) {
+    // Unregister whatever the previous keys were watching, so that the kernel
+    // and `files` agree that nothing is registered.
+    for (std::size_t key = 0; isOpen() && key < keys.size(); ++key) {
+        watch(key, -1, 0);
+    }
+
+    const KeyEntry unused = { -1, 0, -1, -1 };
+    keys.assign(numKeys, unused);
+
+    if (!isOpen()) {
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    return isOpen();
+}
+
+bool EpollPoller::isOpen() const {
+    return epollFd != -1;
+}
+
+void EpollPoller::link(int key, int file) {
+    if (file >= int(files.size())) {
+        const FileEntry empty = { -1, 0, 0 };
+        files.resize(file + 1, empty);
+    }
+
+    KeyEntry&  entry = keys[key];
+    FileEntry& head  = files[file];
+
+    entry.file = file;
+    entry.prev = -1;
+    entry.next = head.head;
+    if (head.head != -1) {
+        keys[head.head].prev = key;
+    }
+    head.head = key;
+
+    if (head.unpollable) {
+        ++numUnpollableKeys;
+    }
+}
+
+void EpollPoller::unlink(int key) {
+    KeyEntry&  entry = keys[key];
+    FileEntry& head  = files[entry.file];
+
+    if (entry.prev == -1) {
+        head.head = entry.next;
+    }
+    else {
+        keys[entry.prev].next = entry.next;
+    }
+    if (entry.next != -1) {
+        keys[entry.next].prev = entry.prev;
+    }
+
+    if (head.unpollable) {
+        --numUnpollableKeys;
+    }
+
+    entry.file = -1;
+    entry.prev = -1;
+    entry.next = -1;
+}
+
+void EpollPoller::update(int file) {
+    FileEntry& entry = files[file];
+
+    unsigned wanted = 0;
+    for (int key = entry.head; key != -1; key = keys[key].next) {
+        wanted |= toEpoll(keys[key].events);
+    }
+
+    if (entry.unpollable) {
+        // `epoll` refused this file before.  It will be reconsidered once
+        // nobody is watching it anymore.
+        if (entry.head == -1) {
+            entry.unpollable = 0;
+        }
+        return;
+    }
+
+    if (wanted == entry.registered) {
+        return;  // nothing to tell the kernel
+    }
+
+    int error;
+    if (entry.registered == 0) {
+        error = control(epollFd, EPOLL_CTL_ADD, file, wanted);
+        if (error == EEXIST) {
+            error = control(epollFd, EPOLL_CTL_MOD, file, wanted);
+        }
+    }
+    else if (wanted == 0) {
+        error = control(epollFd, EPOLL_CTL_DEL, file, 0);
+        if (error == ENOENT || error == EBADF) {
+            error = 0;  // the file was closed, which unregistered it already
+        }
+    }
+    else {
+        error = control(epollFd, EPOLL_CTL_MOD, file, wanted);
+        if (error == ENOENT) {
+            // The file was closed (and so unregistered) and then its
+            // descriptor reused.  Register it anew.
+            error = control(epollFd, EPOLL_CTL_ADD, file, wanted);
+        }
+    }
+
+    switch (error) {
+        case 0:
+            entry.registered = wanted;
+            return;
+        case EPERM:
+            // `epoll` doesn't support this kind of file (e.g. a regular
+            // file).  `::poll` would say that it's always ready.
+            entry.unpollable = POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM;
+            break;
+        case EBADF:
+            entry.unpollable = POLLNVAL;
+            break;
+        default:
+            throw Error(ErrorCode::WATCH_FILE, error);
+    }
+
+    entry.registered = 0;
+    for (int key = entry.head; key != -1; key = keys[key].next) {
+        ++numUnpollableKeys;
+    }
+}
+
+void EpollPoller::watch(int key, int file, short events) {
+    assert(isOpen());
+    assert(key >= 0);
+    assert(key < int(keys.size()));
+
+    if (file < 0) {
+        file   = -1;
+        events = 0;
+    }
+
+    KeyEntry& entry = keys[key];
+    if (entry.file == file && entry.events == events) {
+        return;  // already watching exactly this
+    }
+
+    const int oldFile = entry.file;
+    if (oldFile != -1) {
+        unlink(key);
+    }
+
+    entry.events = events;
+    if (file != -1) {
+        link(key, file);
+    }
+
+    if (oldFile != -1 && oldFile != file) {
+        update(oldFile);
+    }
+    if (file != -1) {
+        update(file);
+    }
+}
+
+int EpollPoller::wait(PollerEvent* ready, const TimePoint* deadline) {
+    assert(isOpen());
+    assert(ready);
+
+    epoll_event events[64];
+    const int   maxEvents = sizeof events / sizeof events[0];
+
+    // If any file is always ready, then there's no point in blocking.
+    int rc = numUnpollableKeys ? ::epoll_wait(epollFd, events, maxEvents, 0)
+                               : waitUntil(events, maxEvents, deadline);
+    if (rc == -1) {
+        const int errorCode = errno;
+        switch (errorCode) {
+            case EINTR:
+                rc = 0;  // signal was caught; fine, nothing is ready
+                break;
+            default:
+                throw Error(ErrorCode::POLL, errorCode);
+        }
+    }
+
+    int numReady = 0;
+    for (int i = 0; i < rc; ++i) {
+        const int   file    = events[i].data.fd;
+        const short revents = fromEpoll(events[i].events);
+
+        if (file == timerFd) {
+            continue;  // the deadline has arrived; that's not a file event
+        }
+
+        assert(file >= 0);
+        assert(file < int(files.size()));
+
+        for (int key = files[file].head; key != -1; key = keys[key].next) {
+            if (const short flags = relevant(revents, keys[key].events)) {
+                ready[numReady].key     = key;
+                ready[numReady].revents = flags;
+                ++numReady;
+            }
+        }
+    }
+
+    if (numUnpollableKeys) {
+        // This is linear in the number of keys, but only happens when
+        // somebody selects on a file that `epoll` can't monitor.
+        for (std::size_t key = 0; key < keys.size(); ++key) {
+            const int file = keys[key].file;
+            if (file == -1 || !files[file].unpollable) {
+                continue;
+            }
+
+            const short revents = files[file].unpollable;
+            if (const short flags = relevant(revents, keys[key].events)) {
+                ready[numReady].key     = key;
+                ready[numReady].revents = flags;
+                ++numReady;
+            }
+        }
+    }
+
+    return numReady;
+}
+
+int EpollPoller::waitUntil(epoll_event*     events,
+                           int              maxEvents,
+                           const TimePoint* deadline) {
+#ifdef CHAN_HAS_EPOLL_PWAIT2
+    if (hasPwait2) {
+        timespec  buffer;
+        const int rc = ::epoll_pwait2(
+            epollFd, events, maxEvents, timeoutTimespec(deadline, &buffer), 0);
+        if (rc != -1 || errno != ENOSYS) {
+            return rc;
+        }
+
+        hasPwait2 = false;  // the kernel is older than Linux 5.11
+    }
+#endif
+
+    if (setTimer(deadline)) {
+        return ::epoll_wait(epollFd, events, maxEvents, -1);
+    }
+
+    return ::epoll_wait(
+        epollFd, events, maxEvents, timeoutMilliseconds(deadline));
+}
+
+bool EpollPoller::setTimer(const TimePoint* deadline) {
+    if (!deadline && !timerArmed) {
+        return false;  // nothing to do
+    }
+
+    if (timerFd == -1) {
+        timerFd =
+            ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerFd == -1) {
+            return false;
+        }
+        if (control(epollFd, EPOLL_CTL_ADD, timerFd, EPOLLIN)) {
+            ::close(timerFd);
+            timerFd = -1;
+            return false;
+        }
+    }
+
+    // Setting the timer also discards any expiration that hasn't been read,
+    // so `timerFd` becomes unready until the new time arrives.  A zero
+    // `it_value` disarms the timer, so a deadline that has already passed is
+    // rounded up to one nanosecond.
+    itimerspec setting = itimerspec();
+    if (deadline) {
+        timeoutTimespec(deadline, &setting.it_value);
+        if (setting.it_value.tv_sec == 0 && setting.it_value.tv_nsec == 0) {
+            setting.it_value.tv_nsec = 1;
+        }
+    }
+
+    if (::timerfd_settime(timerFd, 0, &setting, 0)) {
+        timerArmed = false;
+        return false;
+    }
+
+    timerArmed = deadline != 0;
+    return timerArmed;
+}
+
+}  // namespace chan
+
+#endif  // #ifdef CHAN_HAS_EPOLL
@@ -0,0 +1,117 @@
+#ifndef INCLUDED_CHAN_SELECT_EPOLLPOLLER
+#define INCLUDED_CHAN_SELECT_EPOLLPOLLER
+
+// `EpollPoller` is an implementation of the `Poller` protocol that uses Linux
+// `epoll`.  Each file is registered with the kernel once, when it is first
+// watched, and is thereafter modified only if the set of events of interest
+// changes.  `wait` then visits only the files that are ready, so its cost is
+// proportional to the number of ready keys rather than to the total number of
+// keys.
+//
+// `epoll` is not able to monitor every kind of file.  Regular files, for
+// example, are always ready for reading and writing, and so `epoll_ctl`
+// refuses them.  `EpollPoller` reports such files as ready on every `wait`,
+// which is what `::poll` would do.  Similarly, invalid file descriptors are
+// reported as `POLLNVAL`.
+//
+// Deadlines are honored with nanosecond resolution using `epoll_pwait2`
+// (Linux 5.11 and later).  On older kernels, a `timerfd` registered alongside
+// the watched files serves the same purpose.  Only if neither is available is
+// the deadline rounded up to whole milliseconds.
+//
+// This component is empty unless `CHAN_HAS_EPOLL` is defined (see
+// `chan/select/selectbackend.h`).
+
+#include <chan/select/poller.h>
+#include <chan/select/selectbackend.h>
+
+#ifdef CHAN_HAS_EPOLL
+
+#include <vector>
+
+struct epoll_event;
+
+namespace chan {
+
+class EpollPoller : public Poller {
+    // The keys watching a particular file form a doubly linked list, so that
+    // a key can be added to or removed from a file in constant time.  `prev`
+    // and `next` are keys, where -1 means "none."
+    struct KeyEntry {
+        int   file;  // negative if the key isn't watching anything
+        short events;
+        int   prev;
+        int   next;
+    };
+
+    struct FileEntry {
+        int head;  // first key watching this file, or -1 if none
+
+        // the `epoll` event flags with which this file is currently
+        // registered, or zero if it is not registered
+        unsigned registered;
+
+        // If nonzero, `epoll` refused this file, and so `wait` reports these
+        // `pollfd::revents`-style flags for it every time without consulting
+        // `epoll`.
+        short unpollable;
+    };
+
+    int                    epollFd;
+    std::vector<KeyEntry>  keys;
+    std::vector<FileEntry> files;  // indexed by file descriptor
+    int                    numUnpollableKeys;
+
+    // `timerFd` is a `timerfd` registered with `epollFd`, or -1 if none has
+    // been created yet.  `timerArmed` is whether it is set to expire.
+    // `hasPwait2` is whether `epoll_pwait2` might be supported, i.e. hasn't
+    // yet failed with `ENOSYS`.
+    int  timerFd;
+    bool timerArmed;
+    bool hasPwait2;
+
+    EpollPoller(const EpollPoller&) /* = delete */;
+    EpollPoller& operator=(const EpollPoller&) /* = delete */;
+
+    void link(int key, int file);
+    void unlink(int key);
+    void update(int file);
+
+    // Wait for events as `epoll_wait` does, writing at most the specified
+    // `maxEvents` of them into the specified `events`, until the optionally
+    // specified `deadline`.  Return the result of the underlying system call,
+    // with `errno` set if that result is -1.
+    int waitUntil(epoll_event*     events,
+                  int              maxEvents,
+                  const TimePoint* deadline);
+
+    // Set `timerFd` (creating it if necessary) to expire at the optionally
+    // specified `deadline`, or disarm it if `deadline` is null.  Return
+    // whether `timerFd` will wake up `epoll_wait` at `deadline`.
+    bool setTimer(const TimePoint* deadline);
+
+  public:
+    // Create an `EpollPoller` having no keys and no `epoll` instance.  Call
+    // `reset` before using it.
+    EpollPoller();
+    ~EpollPoller();
+
+    // Discard all keys, and then prepare to monitor files on behalf of the
+    // specified `numKeys` keys, none of which initially monitors any file.
+    // Create an `epoll` instance if this object doesn't have one already.
+    // Return `true` on success, or return `false` if the system is unable to
+    // provide an `epoll` instance, in which case the behavior of `watch` and
+    // `wait` is undefined.
+    bool reset(int numKeys);
+
+    bool isOpen() const;
+
+    void watch(int key, int file, short events);
+    int  wait(PollerEvent* ready, const TimePoint* deadline);
+};
+
+}  // namespace chan
+
+#endif  // #ifdef CHAN_HAS_EPOLL
+
+#endif
@@ -0,0 +1,98 @@
+#include <chan/event/eventcontext.h>
+#include <chan/select/fulfillmentpool.h>
+
+#include <pthread.h>
+
+namespace chan {
+namespace {
+
+struct PooledFulfillment : public SelectorFulfillment {
+    PooledFulfillment* next;
+};
+
+// `spares` is the calling thread's pool.  The first time a thread returns a
+// `SelectorFulfillment` to its pool, the address of its `spares` is stored
+// under `key`, so that when the thread exits, `recycle` moves the pool onto
+// `recycled`.  If that can't be arranged, then the pool is leaked when the
+// thread exits, which is better than failing to return from `select`.
+#if __cplusplus >= 201103
+thread_local
+#else
+__thread
+#endif
+    PooledFulfillment* spares;
+
+#if __cplusplus >= 201103
+thread_local
+#else
+__thread
+#endif
+    bool registered;
+
+pthread_mutex_t    recycledMutex = PTHREAD_MUTEX_INITIALIZER;
+PooledFulfillment* recycled;
+
+pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t  key;
+int            keyError;  // nonzero if `key` couldn't be created
+
+void recycle(void* sparesRaw) {
+    PooledFulfillment** const pool =
+        static_cast<PooledFulfillment**>(sparesRaw);
+    PooledFulfillment* const head = *pool;
+    if (!head) {
+        return;
+    }
+
+    PooledFulfillment* tail = head;
+    while (tail->next) {
+        tail = tail->next;
+    }
+
+    *pool = 0;
+    ::pthread_mutex_lock(&recycledMutex);
+    tail->next = recycled;
+    recycled   = head;
+    ::pthread_mutex_unlock(&recycledMutex);
+}
+
+void createKey() {
+    keyError = ::pthread_key_create(&key, &recycle);
+}
+
+}  // unnamed namespace
+
+SelectorFulfillment* allocateFulfillment() {
+    PooledFulfillment* fulfillment = spares;
+    if (fulfillment) {
+        spares = fulfillment->next;
+        return fulfillment;
+    }
+
+    ::pthread_mutex_lock(&recycledMutex);
+    fulfillment = recycled;
+    if (fulfillment) {
+        recycled = fulfillment->next;
+    }
+    ::pthread_mutex_unlock(&recycledMutex);
+
+    if (!fulfillment) {
+        fulfillment = new PooledFulfillment;
+    }
+
+    return fulfillment;
+}
+
+void deallocateFulfillment(SelectorFulfillment* fulfillment) {
+    PooledFulfillment* const pooled =
+        static_cast<PooledFulfillment*>(fulfillment);
+    pooled->next = spares;
+    spares       = pooled;
+
+    if (!registered) {
+        ::pthread_once(&keyOnce, &createKey);
+        registered = !keyError && !::pthread_setspecific(key, &spares);
+    }
+}
+
+}  // namespace chan
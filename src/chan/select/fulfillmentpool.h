@@ -0,0 +1,28 @@
+#ifndef INCLUDED_CHAN_SELECT_FULFILLMENTPOOL
+#define INCLUDED_CHAN_SELECT_FULFILLMENTPOOL
+
+// This component provides the `SelectorFulfillment`s (see
+// `chan/event/eventcontext.h`) that `Selector`s use.  A `SelectorFulfillment`
+// is never deleted, because a visitor in another thread might look at it long
+// after the selection that it knew about is over.  Instead, each thread keeps
+// the ones it's done with, so that allocating one usually involves neither
+// locking nor the heap, and when the thread exits, they're kept for any thread
+// that needs one.
+
+namespace chan {
+
+class SelectorFulfillment;
+
+// Return a `SelectorFulfillment` from the calling thread's pool, or a new one
+// if the pool is empty.  If an error occurs, throw an exception.
+SelectorFulfillment* allocateFulfillment();
+
+// Return the specified `fulfillment` to the calling thread's pool.  The
+// behavior is undefined unless `fulfillment` was obtained from
+// `allocateFulfillment`, possibly on another thread, and nobody has a claim
+// on it.
+void deallocateFulfillment(SelectorFulfillment* fulfillment);
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1 @@
+#include <chan/select/inlinevector.h>
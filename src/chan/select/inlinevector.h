@@ -0,0 +1,198 @@
+#ifndef INCLUDED_CHAN_SELECT_INLINEVECTOR
+#define INCLUDED_CHAN_SELECT_INLINEVECTOR
+
+// This component provides `InlineVector`, a minimal sequence container that
+// stores up to a fixed number of elements within itself, and resorts to the
+// heap only if it grows beyond that.  `chan::select` uses `InlineVector` so
+// that a `select` having no more than `CHAN_MAX_ARITY` arguments keeps all of
+// its per-call state on the stack.
+//
+// Only the operations that `chan::select` needs are provided.  Iterators are
+// plain pointers, and so are invalidated whenever the elements move from the
+// inline buffer to the heap (or to a bigger heap buffer).  `T` need not be
+// default constructible unless `resize` is used.
+
+#include <algorithm>  // std::max
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <new>
+
+namespace chan {
+
+template <typename T, std::size_t N>
+class InlineVector {
+    union {
+        char buffer[N * sizeof(T)];
+        // The following union members are included to ensure that `buffer`
+        // is adequately aligned for `T` (see `chan/select/lasterror.cpp`).
+        long double dummyLd;
+        double      dummyD;
+        void*       dummyP;
+        long        dummyLi;
+    };
+
+    T*          data;      // either `buffer` or heap storage
+    std::size_t length;    // number of elements
+    std::size_t capacity;  // number of elements that fit in `data`
+
+    InlineVector(const InlineVector&) /* = delete */;
+    InlineVector& operator=(const InlineVector&) /* = delete */;
+
+    T* inlineData() {
+        return reinterpret_cast<T*>(&buffer[0]);
+    }
+
+    // Ensure that `data` has room for at least the specified `minCapacity`
+    // elements, moving to the heap if necessary.
+    void reserve(std::size_t minCapacity) {
+        if (minCapacity <= capacity) {
+            return;
+        }
+
+        const std::size_t newCapacity = std::max(minCapacity, capacity * 2);
+        T* const          newData =
+            static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+
+        std::size_t i = 0;
+        try {
+            for (; i < length; ++i) {
+                new (newData + i) T(data[i]);
+            }
+        }
+        catch (...) {
+            while (i) {
+                newData[--i].~T();
+            }
+            ::operator delete(newData);
+            throw;
+        }
+
+        const std::size_t oldLength = length;
+        clear();
+        release();
+
+        data     = newData;
+        length   = oldLength;
+        capacity = newCapacity;
+    }
+
+    // Return heap storage, if any.  The behavior is undefined unless
+    // `length == 0`.
+    void release() {
+        assert(length == 0);
+        if (data != inlineData()) {
+            ::operator delete(data);
+            data     = inlineData();
+            capacity = N;
+        }
+    }
+
+  public:
+    InlineVector()
+    : data(inlineData())
+    , length(0)
+    , capacity(N) {
+    }
+
+    ~InlineVector() {
+        clear();
+        release();
+    }
+
+    T* begin() {
+        return data;
+    }
+
+    T* end() {
+        return data + length;
+    }
+
+    const T* begin() const {
+        return data;
+    }
+
+    const T* end() const {
+        return data + length;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    T& operator[](std::size_t index) {
+        assert(index < length);
+        return data[index];
+    }
+
+    const T& operator[](std::size_t index) const {
+        assert(index < length);
+        return data[index];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[length - 1];
+    }
+
+    void push_back(const T& value) {
+        if (length == capacity) {
+            // `value` might refer to one of our elements, so copy it before
+            // the elements move.
+            const T copy(value);
+            reserve(length + 1);
+            new (data + length) T(copy);
+        }
+        else {
+            new (data + length) T(value);
+        }
+        ++length;
+    }
+
+    // Destroy the last element.  The behavior is undefined if `empty()`.
+    void pop_back() {
+        assert(length);
+        data[--length].~T();
+    }
+
+    // Destroy all elements.  Any heap storage is kept for later use.
+    void clear() {
+        while (length) {
+            data[--length].~T();
+        }
+    }
+
+    // Destroy all elements and then append the specified `count` copies of
+    // the specified `value`.
+    void assign(std::size_t count, const T& value) {
+        clear();
+        reserve(count);
+        while (length < count) {
+            push_back(value);
+        }
+    }
+
+    // Make `size() == count`, appending default constructed elements or
+    // destroying trailing elements as necessary.
+    void resize(std::size_t count) {
+        while (length > count) {
+            data[--length].~T();
+        }
+        if (count > length) {
+            reserve(count);
+            while (length < count) {
+                push_back(T());
+            }
+        }
+    }
+};
+
+}  // namespace chan
+
+#endif
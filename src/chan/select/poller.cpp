@@ -0,0 +1,43 @@
+#include <chan/select/poller.h>
+#include <chan/time/timepoint.h>
+
+#include <time.h>
+
+namespace chan {
+namespace {
+
+// Return the time from now until the specified `deadline`, or zero if the
+// deadline has passed.
+Duration remainingUntil(const TimePoint& deadline) {
+    const Duration remaining = deadline - now();
+    return remaining < Duration() ? Duration() : remaining;
+}
+
+}  // unnamed namespace
+
+Poller::~Poller() {
+}
+
+int timeoutMilliseconds(const TimePoint* deadline) {
+    if (!deadline) {
+        return -1;
+    }
+
+    const Duration remaining = remainingUntil(*deadline);
+    return (remaining + milliseconds(1) - nanoseconds(1)) / milliseconds(1);
+}
+
+timespec* timeoutTimespec(const TimePoint* deadline, timespec* result) {
+    if (!deadline) {
+        return 0;
+    }
+
+    const Duration remaining    = remainingUntil(*deadline);
+    const long     wholeSeconds = remaining / seconds(1);
+
+    result->tv_sec  = wholeSeconds;
+    result->tv_nsec = (remaining - seconds(wholeSeconds)) / nanoseconds(1);
+    return result;
+}
+
+}  // namespace chan
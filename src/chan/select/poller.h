@@ -0,0 +1,67 @@
+#ifndef INCLUDED_CHAN_SELECT_POLLER
+#define INCLUDED_CHAN_SELECT_POLLER
+
+// This component defines `Poller`, the protocol by which `chan::select` waits
+// for files to become ready, independent of which system IO multiplexing
+// facility (see `chan/select/selectbackend.h`) is doing the waiting.
+//
+// A `Poller` monitors files on behalf of "keys," where each key is a small
+// non-negative integer identifying one event within a `select` invocation.
+// More than one key may monitor the same file.  Readiness is expressed using
+// the same flags as `::poll` (`POLLIN`, `POLLOUT`, `POLLHUP`, etc.), whatever
+// the underlying facility.
+//
+// Deadlines have nanosecond resolution.  Implementations wait using a system
+// call that accepts a `timespec` (e.g. `ppoll` or `epoll_pwait2`) where one is
+// available, so that a `select` involving a sub-millisecond timeout neither
+// spins nor wakes up early.
+
+struct timespec;
+
+namespace chan {
+
+class TimePoint;
+
+// A `PollerEvent` describes the readiness of the file monitored on behalf of
+// `key`.
+struct PollerEvent {
+    int   key;
+    short revents;
+};
+
+class Poller {
+  public:
+    virtual ~Poller();
+
+    // Monitor the specified `file` for the specified `events` (flags as in
+    // `pollfd::events`) on behalf of the specified `key`, replacing whatever
+    // was previously monitored on behalf of `key`.  If `file` is negative,
+    // then stop monitoring on behalf of `key`.  Throw an exception if an
+    // error occurs.
+    virtual void watch(int key, int file, short events) = 0;
+
+    // Block until at least one monitored file is ready, or until the
+    // optionally specified `deadline` passes, or until a signal is caught.
+    // Write a `PollerEvent` for each ready key into the specified `ready`,
+    // which must have room for as many keys as this `Poller` monitors, and
+    // return the number written.  Return zero if no files are ready.  Throw an
+    // exception if an error occurs.
+    virtual int wait(PollerEvent* ready, const TimePoint* deadline) = 0;
+};
+
+// Return the number of milliseconds from now until the specified `deadline`,
+// rounded up, but no less than zero; or return -1 if `deadline` is null.  The
+// result is suitable as a timeout argument to `::poll`.  Rounding up means
+// that a wait might end as much as a millisecond late, but never early, which
+// would cause another wait.
+int timeoutMilliseconds(const TimePoint* deadline);
+
+// Store into the specified `result` the time from now until the specified
+// `deadline`, but no less than zero, and return `result`; or return null if
+// `deadline` is null.  The result is suitable as a timeout argument to
+// `ppoll` or `epoll_pwait2`.
+timespec* timeoutTimespec(const TimePoint* deadline, timespec* result);
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,77 @@
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/select/pollpoller.h>
+
+#include <errno.h>
+#include <time.h>
+
+#include <cassert>
+#include <cstddef>  // std::size_t
+
+namespace chan {
+
+PollPoller::PollPoller()
+: pollFds() {
+}
+
+void PollPoller::reset(int numKeys) {
+    pollfd ignored;
+    ignored.fd      = -1;  // so `::poll` will ignore this entry
+    ignored.events  = 0;
+    ignored.revents = 0;
+
+    pollFds.assign(numKeys, ignored);
+}
+
+void PollPoller::watch(int key, int file, short events) {
+    assert(key >= 0);
+    assert(key < int(pollFds.size()));
+
+    pollfd& pollFd = pollFds[key];
+    pollFd.fd      = file < 0 ? -1 : file;
+    pollFd.events  = file < 0 ? 0 : events;
+    pollFd.revents = 0;
+}
+
+int PollPoller::wait(PollerEvent* ready, const TimePoint* deadline) {
+    assert(ready);
+    assert(!pollFds.empty());
+
+#ifdef CHAN_HAS_PPOLL
+    timespec  buffer;
+    const int rc = ::ppoll(pollFds.begin(),
+                           pollFds.size(),
+                           timeoutTimespec(deadline, &buffer),
+                           0);
+#else
+    const int timeout = timeoutMilliseconds(deadline);
+    const int rc      = ::poll(pollFds.begin(), pollFds.size(), timeout);
+#endif
+
+    if (rc == -1) {
+        const int errorCode = errno;
+        switch (errorCode) {
+            case EINTR:
+                return 0;  // signal was caught; fine, nothing is ready
+            default:
+                throw Error(ErrorCode::POLL, errorCode);
+        }
+    }
+
+    // `::poll` tells us how many files are ready, but not which ones, so we
+    // have to look at all of them.
+    int numReady = 0;
+    for (std::size_t i = 0; i < pollFds.size() && numReady < rc; ++i) {
+        if (pollFds[i].revents == 0) {
+            continue;  // this isn't one of the ready files
+        }
+
+        ready[numReady].key     = i;
+        ready[numReady].revents = pollFds[i].revents;
+        ++numReady;
+    }
+
+    return numReady;
+}
+
+}  // namespace chan
@@ -0,0 +1,45 @@
+#ifndef INCLUDED_CHAN_SELECT_POLLPOLLER
+#define INCLUDED_CHAN_SELECT_POLLPOLLER
+
+// `PollPoller` is the portable implementation of the `Poller` protocol.  It
+// keeps one `pollfd` per key and hands all of them to `::poll` on every call
+// to `wait`, so each `wait` costs time proportional to the number of keys.
+// Where `ppoll` is available (`CHAN_HAS_PPOLL`), it is used instead of
+// `::poll` so that deadlines need not be rounded to milliseconds.
+
+#include <chan/macros/macros.h>
+#include <chan/select/inlinevector.h>
+#include <chan/select/poller.h>
+
+#include <poll.h>
+
+#if defined(__linux__) || defined(__FreeBSD__)
+#define CHAN_HAS_PPOLL 1
+#endif
+
+namespace chan {
+
+class PollPoller : public Poller {
+    // `pollFds[key]` is the `pollfd` monitored on behalf of `key`.  Keys that
+    // aren't monitoring anything have a negative `fd`, which `::poll`
+    // ignores.  Up to `CHAN_MAX_ARITY` of them are stored inline.
+    InlineVector<pollfd, CHAN_MAX_ARITY> pollFds;
+
+    PollPoller(const PollPoller&) /* = delete */;
+    PollPoller& operator=(const PollPoller&) /* = delete */;
+
+  public:
+    // Create a `PollPoller` having no keys.  Call `reset` before using it.
+    PollPoller();
+
+    // Discard all keys, and then prepare to monitor files on behalf of the
+    // specified `numKeys` keys, none of which initially monitors any file.
+    void reset(int numKeys);
+
+    void watch(int key, int file, short events);
+    int  wait(PollerEvent* ready, const TimePoint* deadline);
+};
+
+}  // namespace chan
+
+#endif
@@ -13,6 +13,36 @@
 #endif
 
 namespace chan {
+namespace {
+
+// The state of each thread's pseudo-random sequence.  See
+// `chan/select/lasterror.cpp` for why `__thread` is used in C++98.
+struct ThreadRandomStorage {
+    bool isSeeded;
+    int  state;
+};
+
+#if __cplusplus >= 201103
+thread_local
+#else
+__thread
+#endif
+    ThreadRandomStorage threadRandom;
+
+}  // unnamed namespace
+
+int& threadRandomState() {
+    if (!threadRandom.isSeeded) {
+        seedThreadRandom(systemRandom());
+    }
+
+    return threadRandom.state;
+}
+
+void seedThreadRandom(int seed) {
+    threadRandom.state    = seed;
+    threadRandom.isSeeded = true;
+}
 
 #if __cplusplus >= 201103
 
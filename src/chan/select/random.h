@@ -4,6 +4,14 @@
 // This component provides facilities for generating "weak" pseudo-random
 // integer sequences, and for applying these sequences to shuffling the
 // elements of a sequence.  `chan::select` uses this to break ties.
+//
+// Each thread has its own pseudo-random sequence, available through
+// `ThreadRandom15`.  A thread's sequence is seeded from `systemRandom` the
+// first time the thread uses it, so that `select` need not consult the
+// system's entropy source (a system call, typically) more than once per
+// thread.  `seedThreadRandom` instead seeds the calling thread's sequence with
+// a specified value, which makes the order in which `select` considers its
+// events reproducible.
 
 #include <algorithm>  // where std::swap is in C++98
 #include <cassert>
@@ -58,13 +66,43 @@ class Random15 {
 // source (e.g. "/dev/urandom"), or return zero if no such source is available.
 int systemRandom();
 
+// Return a reference to the state of the calling thread's pseudo-random
+// sequence, suitable for use with `random15`.  If the sequence has not yet
+// been seeded on this thread, seed it using `systemRandom` first.
+int& threadRandomState();
+
+// Seed the calling thread's pseudo-random sequence with the specified `seed`.
+// Subsequent uses of `ThreadRandom15` on this thread, including those made by
+// `select`, will produce the same values as would a `Random15` constructed
+// with `seed`.
+void seedThreadRandom(int seed);
+
+// This function-like object produces values from the calling thread's
+// pseudo-random sequence of 15-bit positive integers.  The behavior is
+// undefined if a `ThreadRandom15` is used by a thread other than the one that
+// created it.
+class ThreadRandom15 {
+    int& state;
+
+  public:
+    ThreadRandom15()
+    : state(threadRandomState()) {
+    }
+
+    int operator()() {
+        return random15(state);
+    }
+};
+
 // Return an random integer from the specified range `[low, high]` (inclusive
 // on both sides), where each integer in the range has an equal probability of
 // being returned. Use the specified `generator` to provide a pseudo-random
-// sequence of 15-bit positive integers.  The behavior is undefined unless
-// `low <= high` and also that `high - low + 1` can be expressed using no more
-// than 15 bits (i.e. is less than or equal `2**16 - 1`, or 65535).
-inline int randomInt(int low, int high, Random15& getRandom) {
+// sequence of 15-bit positive integers, e.g. a `Random15` or a
+// `ThreadRandom15`.  The behavior is undefined unless `low <= high` and also
+// that `high - low + 1` can be expressed using no more than 15 bits (i.e. is
+// less than or equal `2**16 - 1`, or 65535).
+template <typename GENERATOR>
+int randomInt(int low, int high, GENERATOR& getRandom) {
     const int upper = high - low + 1;
     assert(upper >= 1);
 
@@ -93,8 +131,8 @@ inline int randomInt(int low, int high, Random15& getRandom) {
     return low + candidate;
 }
 
-template <typename ITERATOR>
-void shuffle(ITERATOR begin, ITERATOR end, Random15& generator) {
+template <typename ITERATOR, typename GENERATOR>
+void shuffle(ITERATOR begin, ITERATOR end, GENERATOR& generator) {
     // This implementation is based off of the "third version" of the
     // "possible implementation" section of the following cppreference.com
     // article, accessed July 17, 2019:
@@ -113,23 +151,21 @@ void shuffle(ITERATOR begin, ITERATOR end, Random15& generator) {
     }
 }
 
-template <typename CONTAINER>
-void shuffle(CONTAINER& container, Random15& generator) {
+template <typename CONTAINER, typename GENERATOR>
+void shuffle(CONTAINER& container, GENERATOR& generator) {
     shuffle(container.begin(), container.end(), generator);
 }
 
-// Note that for repeated shuffling, it's better to use the overloads of
-// `shuffle` that take `Random15&`, so that `systemRandom` need not get called
-// as often.
+// Shuffle the elements of `[begin, end)` using the calling thread's
+// pseudo-random sequence.
 template <typename ITERATOR>
 void shuffle(ITERATOR begin, ITERATOR end) {
-    Random15 generator(systemRandom());
+    ThreadRandom15 generator;
     shuffle(begin, end, generator);
 }
 
-// Note that for repeated shuffling, it's better to use the overloads of
-// `shuffle` that take `Random15&`, so that `systemRandom` need not get called
-// as often.
+// Shuffle the elements of the specified `container` using the calling
+// thread's pseudo-random sequence.
 template <typename CONTAINER>
 void shuffle(CONTAINER& container) {
     shuffle(container.begin(), container.end());
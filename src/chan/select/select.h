@@ -40,6 +40,34 @@ int select(EVENTS ...events);
 
 CHAN_MAPP(DECLARE_SELECT, (CHAN_SEQ(CHAN_MAX_ARITY)))
 
+// Wait until any of the events in the specified range `[begin, end)` is
+// fulfilled and return the zero-based position within the range of whichever
+// is fulfilled first.  If an error occurs, return a negative value indicating
+// the kind of error.  Unlike `select`, the number of events need not be known
+// at compile time, and is not limited to `CHAN_MAX_ARITY`.  Since `EventRef`
+// is type-erased, the range may contain events of different kinds.  Each
+// `EventRef` refers to an event object that must outlive the call.  The
+// behavior is undefined if the range is empty.
+//
+// When there are many events, `selectRange` waits using `epoll` where
+// available (see `chan/select/selectbackend.h`), so that the cost of each
+// wakeup is proportional to the number of ready files rather than to the
+// number of events.  For a set of events that is selected upon repeatedly,
+// `SelectSet` (see `chan/select/selectset.h`) additionally avoids setting up
+// the selection from scratch each time.
+int selectRange(EventRef* begin, EventRef* end);
+
+// Wait until any of the events in the specified `events` is fulfilled and
+// return the zero-based position within `events` of whichever is fulfilled
+// first, as `selectRange(EventRef*, EventRef*)` does.  `CONTAINER` is a
+// contiguous sequence of `EventRef`, such as `std::vector<EventRef>`.  The
+// behavior is undefined if `events` is empty.
+template <typename CONTAINER>
+int selectRange(CONTAINER& events) {
+    EventRef* const begin = &events[0];
+    return selectRange(begin, begin + events.size());
+}
+
 // This component-private function is an implementation detail of
 // `chan::select`.
 int selectImpl(EventRef* eventsBegin, const EventRef* eventsEnd);
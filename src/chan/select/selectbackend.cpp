@@ -0,0 +1,18 @@
+#include <chan/select/selectbackend.h>
+
+namespace chan {
+namespace {
+
+SelectBackend::Value currentBackend = SelectBackend::AUTOMATIC;
+
+}  // unnamed namespace
+
+SelectBackend selectBackend() CHAN_NOEXCEPT {
+    return currentBackend;
+}
+
+void setSelectBackend(SelectBackend backend) CHAN_NOEXCEPT {
+    currentBackend = backend;
+}
+
+}  // namespace chan
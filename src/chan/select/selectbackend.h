@@ -0,0 +1,80 @@
+#ifndef INCLUDED_CHAN_SELECT_SELECTBACKEND
+#define INCLUDED_CHAN_SELECT_SELECTBACKEND
+
+// This component provides a means of choosing which system IO multiplexing
+// facility `chan::select` uses to wait for files to become ready.
+//
+// `::poll` is always available, and is the best choice for the small number
+// of events that a typical `select` invocation involves.  On Linux, `epoll`
+// is also available.  `epoll` costs a system call per file to set up, but
+// thereafter it visits only the files that are actually ready, which makes it
+// the better choice when very many events are selected upon repeatedly, as
+// with a `SelectSet`.  For a single selection, even of very many events,
+// `::poll` is cheaper.
+//
+// Linux 5.11 and later also offer `io_uring`, which submits every changed
+// poll request and waits for completions in a single system call (see
+// `chan/select/uringpoller.h`).  Like `epoll`, it pays off only for events
+// selected upon repeatedly, and creating the ring costs several system calls,
+// so it is never chosen automatically.
+//
+// The choice can be made at build time or at run time.  At build time,
+// defining the preprocessor macro `CHAN_NO_EPOLL` omits `epoll` support
+// entirely, and `CHAN_NO_IO_URING` likewise omits `io_uring` support (which
+// requires the kernel's `<linux/io_uring.h>` header).  At run time,
+// `setSelectBackend` overrides the default choice, which is
+// `SelectBackend::AUTOMATIC`.
+
+#include <chan/errors/noexcept.h>
+
+#if defined(__linux__) && !defined(CHAN_NO_EPOLL)
+#define CHAN_HAS_EPOLL 1
+#endif
+
+#if defined(__linux__) && !defined(CHAN_NO_IO_URING)
+#define CHAN_HAS_IO_URING 1
+#endif
+
+namespace chan {
+
+// Simulate C++11's `enum class` in C++98.
+class SelectBackend {
+  public:
+    enum Value {
+        AUTOMATIC,  // `EPOLL` for many events selected upon more than
+                    // once, otherwise `POLL`
+        POLL,       // always `::poll`
+        EPOLL,      // `epoll` where available, otherwise `::poll`
+        IO_URING    // `io_uring` where available, otherwise `::poll`
+    };
+
+  private:
+    Value value;
+
+  public:
+    SelectBackend(Value value) CHAN_NOEXCEPT
+    : value(value) {
+    }
+
+    operator Value() const CHAN_NOEXCEPT {
+        return value;
+    }
+};
+
+// `SelectBackend::AUTOMATIC` chooses `epoll` (where available) when at least
+// this many events are selected upon for the second time or later (e.g. by a
+// `SelectSet`).
+const int epollThreshold = 64;
+
+// Return the `SelectBackend` most recently specified by `setSelectBackend`,
+// or `SelectBackend::AUTOMATIC` if `setSelectBackend` has not been called.
+SelectBackend selectBackend() CHAN_NOEXCEPT;
+
+// Use the specified `backend` for subsequent calls to `select`.  Note that
+// this setting is process-wide and is not synchronized, so it is best called
+// once at startup before any threads are created.
+void setSelectBackend(SelectBackend backend) CHAN_NOEXCEPT;
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,288 @@
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/event/eventcontext.h>
+#include <chan/event/ioevent.h>
+#include <chan/files/threadwakeup.h>
+#include <chan/select/fulfillmentpool.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/poller.h>
+#include <chan/select/pollpoller.h>  // CHAN_HAS_PPOLL
+#include <chan/select/selectone.h>
+#include <chan/time/timepoint.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+#include <cassert>
+#include <exception>
+
+namespace chan {
+namespace {
+
+// Block until the specified `file` is ready for the specified `events` (flags
+// as in `pollfd::events`), or until the optionally specified `deadline`, or
+// until a signal is caught.  If `file` is negative, just wait.  Return the
+// file's `revents`, or zero if it isn't ready.  Throw an exception if an
+// error occurs.
+short pollOne(int file, short events, const TimePoint* deadline) {
+    pollfd pollFd;
+    pollFd.fd      = file;
+    pollFd.events  = events;
+    pollFd.revents = 0;
+
+    const nfds_t numFds = file < 0 ? 0 : 1;
+#ifdef CHAN_HAS_PPOLL
+    timespec  buffer;
+    const int rc =
+        ::ppoll(&pollFd, numFds, timeoutTimespec(deadline, &buffer), 0);
+#else
+    const int rc = ::poll(&pollFd, numFds, timeoutMilliseconds(deadline));
+#endif
+
+    if (rc == -1) {
+        const int errorCode = errno;
+        if (errorCode == EINTR) {
+            return 0;  // signal was caught; fine, nothing is ready
+        }
+
+        throw Error(ErrorCode::POLL, errorCode);
+    }
+
+    return rc ? pollFd.revents : 0;
+}
+
+// A `SingleSelector` is the state of a `selectOne` invocation.  It plays the
+// role of `Selector` in the protocol described in `chan/event/README.md`, and
+// claims its `SelectorFulfillment` in the same way (see
+// `chan/event/eventcontext.h`), but its one event always has key zero.
+class SingleSelector {
+    EventRef             event;
+    SelectorFulfillment* fulfillment;
+    unsigned             generation;
+
+    // the most recent `IoEvent` returned by `event`
+    IoEvent ioEvent;
+
+    // whether `event` has had `file` called, and is neither fulfilled nor
+    // canceled, i.e. whether it's owed a call to `cancel`
+    bool isActive;
+
+    // whether `fulfillment` was claimed on behalf of `event` while it's being
+    // called
+    bool claimed;
+
+    SingleSelector(const SingleSelector&) /* = delete */;
+    SingleSelector& operator=(const SingleSelector&) /* = delete */;
+
+    // Claim `fulfillment`, and call `file` on `event` if it isn't active, or
+    // `fulfill` if it is.  Return whether `event` is now fulfilled, either by
+    // itself or by an event in some other `select`.
+    bool attempt();
+
+    // Cancel `event`, which some other `select` fulfilled, and return `true`.
+    bool remoteWinner();
+
+    // Block until `ioEvent` might be ready, and return whether it is, or
+    // return `false` after waking for some other reason.
+    bool wait();
+
+    Error handleError(const Error& caughtError);
+
+  public:
+    explicit SingleSelector(EventRef event)
+    : event(event)
+    , fulfillment(allocateFulfillment())
+    , generation(fulfillment->renew())
+    , ioEvent()
+    , isActive(false)
+    , claimed(false) {
+        this->event.touch();
+    }
+
+    ~SingleSelector() {
+        deallocateFulfillment(fulfillment);
+    }
+
+    int operator()();
+};
+
+int SingleSelector::operator()() {
+    try {
+        bool done = attempt();
+        while (!done) {
+            const bool ready = wait();
+
+            // As in `Selector::doPoll`, if some other `select` fulfilled the
+            // event meanwhile, don't bother checking what woke us up.
+            if (fulfillment->fulfilledEventKey(generation) >= 0) {
+                done = remoteWinner();
+            }
+            else if (ready) {
+                done = attempt();
+            }
+        }
+
+        return 0;
+    }
+    catch (const Error& error) {
+        const Error finalError = handleError(error);
+        setLastError(finalError);
+        return finalError.code();
+    }
+    catch (const std::exception& error) {
+        const Error wrapper(error.what());
+        const Error finalError = handleError(wrapper);
+        setLastError(finalError);
+        return finalError.code();
+    }
+    catch (...) {
+        const Error error(ErrorCode::OTHER);
+        const Error finalError = handleError(error);
+        setLastError(finalError);
+        return finalError.code();
+    }
+}
+
+bool SingleSelector::attempt() {
+    assert(!claimed);
+
+    // If some other `select` has a claim on `fulfillment`, this waits for it
+    // to either fulfill the event or release its claim.
+    if (!fulfillment->claim(generation)) {
+        return remoteWinner();
+    }
+
+    claimed = true;
+    if (isActive) {
+        ioEvent = event.fulfill(ioEvent);
+    }
+    else {
+        ioEvent  = event.file(EventContext(fulfillment, generation, 0));
+        isActive = true;
+    }
+    claimed = false;
+
+    // See `Selector::checkForFulfillment`.
+    const EventKey state = fulfillment->fulfilledEventKey(generation);
+    if (ioEvent.fulfilled) {
+        if (state == SelectorFulfillment::CLAIMED) {
+            fulfillment->fulfill(0);
+        }
+        else {
+            assert(state == 0);
+        }
+        isActive = false;
+        return true;
+    }
+    else if (state == SelectorFulfillment::CLAIMED) {
+        fulfillment->release();
+        return false;
+    }
+    else {
+        return remoteWinner();
+    }
+}
+
+bool SingleSelector::remoteWinner() {
+    assert(fulfillment->fulfilledEventKey(generation) == 0);
+    assert(isActive);
+
+    // It's inactive beforehand so that it isn't canceled again if `cancel`
+    // throws.
+    isActive = false;
+    event.cancel(ioEvent);
+    return true;
+}
+
+bool SingleSelector::wait() {
+    if (ioEvent.otherwise) {
+        // Nothing else could be fulfilled, so `otherwise` is.
+        return true;
+    }
+
+    if (ioEvent.timeout) {
+        if (ioEvent.expiration <= now()) {
+            return true;
+        }
+
+        pollOne(-1, 0, &ioEvent.expiration);
+        return false;  // check the time again
+    }
+
+    assert(ioEvent.read || ioEvent.write);
+
+#ifdef CHAN_HAS_FUTEX
+    if (ioEvent.notification) {
+        // A channel event waits on the thread's `ThreadWakeup`, which needn't
+        // be polled when it's the only thing being waited on.
+        return awaitWakeup(threadWakeup(), 0);
+    }
+#endif
+
+    short events = 0;
+    if (ioEvent.read) {
+        events |= POLLIN | POLLRDNORM | POLLRDBAND | POLLPRI;
+    }
+    if (ioEvent.write) {
+        events |= POLLOUT | POLLWRNORM | POLLWRBAND;
+    }
+
+    const short revents = pollOne(ioEvent.file, events, 0);
+    if (!revents) {
+        return false;
+    }
+
+    // As in `Selector::handleFileEvent`, tell `fulfill` what happened.
+    if (revents & POLLHUP) {
+        ioEvent.hangup = true;
+    }
+    if (revents & POLLERR) {
+        ioEvent.error = true;
+    }
+    if (revents & POLLNVAL) {
+        ioEvent.invalid = true;
+    }
+
+    return true;
+}
+
+Error SingleSelector::handleError(const Error& originalError) {
+    // See `Selector::handleError`.
+    const bool holdingClaim =
+        claimed && fulfillment->fulfilledEventKey(generation) ==
+                       SelectorFulfillment::CLAIMED;
+    claimed = false;
+    fulfillment->forbid(holdingClaim);
+
+    if (!isActive) {
+        return originalError;
+    }
+
+    isActive = false;
+    try {
+        event.cancel(ioEvent);
+    }
+    catch (const std::exception& anotherError) {
+        Error combinedError(ErrorCode::SELECT_UNWINDING);
+        combinedError.appendMessage(originalError.what());
+        combinedError.appendMessage(anotherError.what());
+        return combinedError;
+    }
+    catch (...) {
+        Error combinedError(ErrorCode::SELECT_UNWINDING);
+        combinedError.appendMessage(originalError.what());
+        combinedError.appendMessage(ErrorCode(ErrorCode::OTHER).message());
+        return combinedError;
+    }
+
+    return originalError;
+}
+
+}  // unnamed namespace
+
+int selectOne(EventRef event) {
+    return SingleSelector(event)();
+}
+
+}  // namespace chan
@@ -0,0 +1,29 @@
+#ifndef INCLUDED_CHAN_SELECT_SELECTONE
+#define INCLUDED_CHAN_SELECT_SELECTONE
+
+// This component provides `selectOne`, which waits for a single event as
+// `select` would, but without a `Selector` (see `chan/select/selector.h`).
+// With only one event there's nothing to shuffle, no argument index to map,
+// and at most one file to wait on, so `selectOne` keeps its state in a few
+// local variables and waits on the event's file directly: a `futex` wait for a
+// channel event on Linux, or `::poll` on a single `pollfd` otherwise.
+//
+// A plain blocking operation, such as `chan.send(value);` or
+// `int n = file.read(buffer, size);`, is a `select` of one event.  `select`
+// passes any such invocation to `selectOne`, and events that select upon
+// themselves in their destructors or conversion operators call `selectOne`
+// directly.  `selectRange` always uses a `Selector`, even for one event.
+
+#include <chan/event/eventref.h>
+
+namespace chan {
+
+// Wait until the specified `event` is fulfilled and return zero.  If an error
+// occurs, return a negative value indicating the kind of error, and record
+// the error as `lastError()`, exactly as `select(event)` does.  Call `touch`
+// on the event first.
+int selectOne(EventRef event);
+
+}  // namespace chan
+
+#endif
@@ -0,0 +1,662 @@
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+#include <chan/event/eventcontext.h>
+#include <chan/files/threadwakeup.h>
+#include <chan/select/fulfillmentpool.h>
+#include <chan/select/lasterror.h>
+#include <chan/select/random.h>
+#include <chan/select/selectbackend.h>
+#include <chan/select/selector.h>
+#include <chan/time/timepoint.h>
+
+#include <poll.h>
+#include <time.h>
+
+#include <algorithm>  // std::push_heap, std::pop_heap
+#include <cassert>
+#include <cstddef>   // std::size_t
+#include <iterator>  // std::distance
+
+namespace chan {
+namespace {
+
+#ifdef CHAN_HAS_EPOLL
+// Return whether `select` ought to use `epoll` rather than `::poll` to wait on
+// the specified `numEvents` events, which the same `Selector` has already
+// selected upon the specified `numPreviousSelections` times.  Registering a
+// file with `epoll` costs a system call, which pays off only if the
+// registration is used again, so `SelectBackend::AUTOMATIC` starts with
+// `::poll` and switches to `epoll` on the second selection.
+bool wantEpoll(std::size_t numEvents, int numPreviousSelections) {
+    switch (selectBackend()) {
+        case SelectBackend::POLL:
+        case SelectBackend::IO_URING:
+            return false;
+        case SelectBackend::EPOLL:
+            return true;
+        default:
+            assert(selectBackend() == SelectBackend::AUTOMATIC);
+            return numPreviousSelections > 0 &&
+                   numEvents >= std::size_t(epollThreshold);
+    }
+}
+#endif
+
+// This function-like object orders `TimerEntry`s so that the standard heap
+// algorithms, which make max-heaps, make a min-heap by expiration.
+struct LaterExpiration {
+    bool operator()(const TimerEntry& left, const TimerEntry& right) const {
+        return left.expiration > right.expiration;
+    }
+};
+
+}  // unnamed namespace
+
+Selector::Selector()
+: events()
+, records()
+, positions()
+, readyEvents()
+, fulfillment()
+, generation()
+, timers()
+, nextTimerSequence()
+, pollPoller()
+, poller()
+, numSelections()
+, watchingWakeup()
+, watchingFiles()
+, polledWakeup()
+, claimed() {
+}
+
+Selector::Selector(EventRef* begin, const EventRef* end)
+: events()
+, records()
+, positions()
+, readyEvents()
+, fulfillment()
+, generation()
+, timers()
+, nextTimerSequence()
+, pollPoller()
+, poller()
+, numSelections()
+, watchingWakeup()
+, watchingFiles()
+, polledWakeup()
+, claimed() {
+    for (EventRef* event = begin; event != end; ++event) {
+        append(*event);
+    }
+}
+
+Selector::~Selector() {
+    if (fulfillment) {
+        deallocateFulfillment(fulfillment);
+    }
+}
+
+void Selector::append(EventRef event) {
+    events.push_back(event);
+
+    // Call `touch` on the event so that the event knows that it is now part
+    // of a `select` statement.  In response to this, the event might set a
+    // flag within itself that prevents it from blocking in its destructor,
+    // for example.  `touch` will not throw an exception.
+    events.back().touch();
+
+    // `poller` was prepared for a different number of events.
+    poller        = 0;
+    numSelections = 0;
+}
+
+void Selector::replace(int index, EventRef event) {
+    assert(index >= 0);
+    assert(index < size());
+
+    events[index] = event;
+    events[index].touch();  // see `append`
+}
+
+void Selector::clear() {
+    events.clear();
+    poller        = 0;
+    numSelections = 0;
+}
+
+int Selector::size() const {
+    return events.size();
+}
+
+void Selector::prepare() {
+    const std::size_t numEvents = events.size();
+    assert(numEvents);
+
+    records.clear();
+    for (std::size_t i = 0; i < numEvents; ++i) {
+        records.push_back(PollRecord(events[i], i));
+    }
+
+    positions.resize(numEvents);
+    readyEvents.resize(numEvents);
+    timers.clear();
+    nextTimerSequence = 1;
+    watchingWakeup    = false;
+    watchingFiles     = false;
+    claimed           = false;
+    assert(!polledWakeup);
+
+    // Events in other `Selector`s might yet look at our previous selection's
+    // generation of `fulfillment`, but they'll see that it's over.
+    if (!fulfillment) {
+        fulfillment = allocateFulfillment();
+    }
+    generation = fulfillment->renew();
+
+    ++numSelections;
+
+    if (poller && (poller != &pollPoller || numSelections != 2)) {
+        return;  // still good from last time
+    }
+
+    // Either this is the first selection since the events were last appended
+    // or removed, or it's the second, in which case `epoll` might now be
+    // worthwhile.
+
+#ifdef CHAN_HAS_IO_URING
+    // If `io_uring` is wanted but unavailable, fall back to `::poll`.
+    if (selectBackend() == SelectBackend::IO_URING &&
+        uringPoller.reset(numEvents)) {
+        poller = &uringPoller;
+        return;
+    }
+#endif
+
+#ifdef CHAN_HAS_EPOLL
+    // If `epoll` is wanted but unavailable, fall back to `::poll`.
+    if (wantEpoll(numEvents, numSelections - 1) &&
+        epollPoller.reset(numEvents)) {
+        poller = &epollPoller;
+        return;
+    }
+#endif
+
+    if (poller != &pollPoller) {
+        pollPoller.reset(numEvents);
+        poller = &pollPoller;
+    }
+}
+
+int Selector::operator()() {
+    // When an event is finally fulfilled, we'll refer to its position in
+    // `records` using `winner`.  Its argument index will then be returned.
+    // `records.end()` means that we don't yet have a winner.
+    prepare();
+    PollRecord* winner = records.end();
+
+    // Randomize the order of the `PollRecord`s so that a highly available
+    // event in front won't always get selected.  This uses the calling
+    // thread's pseudo-random sequence (see `chan/select/random.h`), which
+    // involves no system calls once the thread has seeded it.
+    shuffle(records);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        positions[records[i].argumentIndex] = i;
+    }
+
+    // `fulfillment` is claimed only while an event's `file` or `fulfill` is
+    // being called, so that an event in a different `Selector` can fulfill
+    // one of ours at any other time, including while we're busy with
+    // something else.
+    assert(fulfillment);
+
+    try {
+        // initial setup of `records`.  Along the way, note the first
+        // `otherwise` event, if any, and whether any event involves a file
+        // other than a notification file (see `IoEvent::notification`).
+        PollRecord* fallback = records.end();
+        bool        anyFiles = false;
+        for (PollRecord* it = records.begin();
+             it != records.end() && winner == records.end();
+             ++it) {
+            winner = claim();
+            if (winner != records.end()) {
+                break;
+            }
+
+            PollRecord& record = *it;
+            // Use the index of `record` within `records` as the `EventKey`.
+            const EventKey key = std::distance(records.begin(), it);
+            record.ioEvent = record.event.file(
+                EventContext(fulfillment, generation, key));
+            record.state   = PollRecord::ACTIVE;
+
+            winner = checkForFulfillment(it);
+            if (winner == records.end()) {
+                watch(it);
+            }
+
+            if (record.ioEvent.otherwise && fallback == records.end()) {
+                fallback = it;
+            }
+            const IoEvent& io = record.ioEvent;
+            anyFiles = anyFiles || ((io.read || io.write) && !io.notification);
+        }
+
+        // If there's an `otherwise` event, then we don't wait.
+        if (winner == records.end() && fallback != records.end()) {
+            winner = handleOtherwise(fallback, anyFiles);
+        }
+
+        // Keep waiting until we either fulfill an event or throw an
+        // exception.
+        while (winner == records.end()) {
+            winner = doPoll();
+        }
+
+        // Now that we have a winner, call `cancel` on all of the other active
+        // events.
+        for (PollRecord* it = records.begin(); it != records.end(); ++it) {
+            if (it != winner && it->state == PollRecord::ACTIVE) {
+                PollRecord& record = *it;
+                record.event.cancel(record.ioEvent);
+                record.state = PollRecord::DONE;
+            }
+        }
+
+        stopPolling();
+        assert(winner != records.end());
+
+        // `records` will have been shuffled, so the winner's position within
+        // `records` is not its argument index.  The record remembers it.
+        return winner->argumentIndex;
+    }
+    catch (const Error& error) {
+        const Error finalError = handleError(error);
+        setLastError(finalError);
+        return finalError.code();
+    }
+    catch (const std::exception& error) {
+        const Error wrapper(error.what());
+        const Error finalError = handleError(wrapper);
+        setLastError(finalError);
+        return finalError.code();
+    }
+    catch (...) {
+        const Error error(ErrorCode::OTHER);
+        const Error finalError = handleError(error);
+        setLastError(finalError);
+        return finalError.code();
+    }
+}
+
+void Selector::watch(PollRecord* recordIter) {
+    // The key within `poller` is the argument index, rather than the
+    // position within `records`, so that a file watched by the same event in
+    // consecutive selections stays registered even though `records` is
+    // shuffled in between.
+    const int      key = recordIter->argumentIndex;
+    const IoEvent& io  = recordIter->ioEvent;
+
+    if (io.otherwise) {
+        // It's an `otherwise` event, which `operator()` handles itself.
+        poller->watch(key, -1, 0);
+        return;
+    }
+
+    if (io.timeout) {
+        // It's a timeout event.  Timeouts are handled by `doPoll`, not by
+        // `poller`, so make sure `poller` ignores this record, and add it to
+        // `timers` instead.  Any earlier entry for this record is now stale.
+        poller->watch(key, -1, 0);
+
+        const TimerEntry entry = {
+            io.expiration, int(recordIter - records.begin()), nextTimerSequence
+        };
+        recordIter->timerSequence = nextTimerSequence++;
+        timers.push_back(entry);
+        std::push_heap(timers.begin(), timers.end(), LaterExpiration());
+        return;
+    }
+
+    // Otherwise, `io` is a read/write event on some file.
+    short events = 0;
+    if (io.read) {
+        events |= POLLIN | POLLRDNORM | POLLRDBAND | POLLPRI;
+    }
+    if (io.write) {
+        events |= POLLOUT | POLLWRNORM | POLLWRBAND;
+    }
+
+    poller->watch(key, io.file, events);
+
+    if (io.notification) {
+        watchingWakeup = true;
+    }
+    else {
+        watchingFiles = true;
+    }
+
+    // Once both kinds of file are involved, the `ThreadWakeup` has to be
+    // waited on with `poller` like any other file, for the rest of the
+    // selection.
+    if (watchingWakeup && watchingFiles && !polledWakeup) {
+        polledWakeup = &threadWakeup();
+        startPollingWakeup(*polledWakeup);
+    }
+}
+
+PollRecord* Selector::claim() {
+    assert(!claimed);
+
+    // If some other `Selector` has a claim on `fulfillment`, this waits for
+    // it to either fulfill one of our events or release its claim.
+    if (fulfillment->claim(generation)) {
+        claimed = true;
+        return records.end();
+    }
+
+    return remoteWinner();
+}
+
+PollRecord* Selector::checkForFulfillment(PollRecord* recordIter) {
+    PollRecord& record = *recordIter;
+    assert(claimed);
+    claimed = false;
+
+    // The event might have returned an `IoEvent` indicating that the event is
+    // fulfilled.  If not, then the claim on `fulfillment` is usually still
+    // ours, and we release it.  However, a `Chan` event might have let go of
+    // the claim temporarily (see `chan/chanevents/fulfillmentclaim.h`), during
+    // which an event in some other `Selector` fulfilled one of ours.
+    const EventKey state = fulfillment->fulfilledEventKey(generation);
+    const EventKey key   = recordIter - records.begin();
+    if (record.ioEvent.fulfilled) {
+        // An event that reports itself fulfilled usually still has our claim,
+        // in which case we mark this `select` statement as done, for anybody
+        // watching.  A visiting `Chan` event will have done so already.
+        if (state == SelectorFulfillment::CLAIMED) {
+            fulfillment->fulfill(key);
+        }
+        else {
+            assert(state == key);
+        }
+
+        record.state = PollRecord::DONE;
+        return recordIter;
+    }
+    else if (state == SelectorFulfillment::CLAIMED) {
+        fulfillment->release();
+        return records.end();
+    }
+    else {
+        return remoteWinner();
+    }
+}
+
+PollRecord* Selector::remoteWinner() {
+    const EventKey index = fulfillment->fulfilledEventKey(generation);
+    assert(index >= 0);
+    assert(index < int(records.size()));
+
+    // If `winner` had returned a fulfilled `IoEvent` from its `fulfill`
+    // method, then it would not have `cancel` called on it afterward.
+    // However, in this case, fulfillment happened in some other `select`, and
+    // so we must call cancel on it.  It's `DONE` beforehand so that it isn't
+    // canceled again if `cancel` throws.
+    PollRecord* const winner = records.begin() + index;
+    winner->state            = PollRecord::DONE;
+    winner->event.cancel(winner->ioEvent);
+    return winner;
+}
+
+PollRecord* Selector::doPoll() {
+    // The `deadline` (timeout), if any, is the earliest expiration in
+    // `timers`.
+    discardStaleTimers();
+    const TimePoint* deadline = 0;  // null means "no deadline"
+    if (!timers.empty()) {
+        deadline = &timers.front().expiration;
+    }
+
+    assert(!readyEvents.empty());
+    assert(fulfillment);
+
+    // While we wait, an event in a different `Selector` could possibly claim
+    // `fulfillment`, mark one of our events as fulfilled, and wake us up by
+    // triggering an event on one of the files we're monitoring.
+    assert(!claimed);
+    const int numReady = wait(deadline);
+
+    // If one of our events is fulfilled, then we don't even bother checking
+    // what woke us up.
+    if (fulfillment->fulfilledEventKey(generation) >= 0) {
+        return remoteWinner();
+    }
+
+    if (numReady == 0) {
+        // Either we timed out, or a signal interrupted the wait.  Either way,
+        // check for expired timeouts.
+        return handleTimeout();
+    }
+
+    return handleFileEvent(numReady);
+}
+
+int Selector::wait(const TimePoint* deadline) {
+#ifdef CHAN_HAS_FUTEX
+    if (watchingWakeup && !polledWakeup) {
+        // Only channel events are waiting, and they all share the thread's
+        // `ThreadWakeup`.
+        timespec buffer;
+        if (!awaitWakeup(threadWakeup(), timeoutTimespec(deadline, &buffer))) {
+            return 0;
+        }
+
+        // Any of them could be the one woken up, so report them all, in
+        // argument order, as `poller` would have.
+        int numReady = 0;
+        for (std::size_t key = 0; key < records.size(); ++key) {
+            const PollRecord& record = records[positions[key]];
+            if (record.state == PollRecord::ACTIVE &&
+                record.ioEvent.notification) {
+                readyEvents[numReady].key     = key;
+                readyEvents[numReady].revents = POLLIN;
+                ++numReady;
+            }
+        }
+
+        return numReady;
+    }
+#endif
+
+    return poller->wait(&readyEvents.front(), deadline);
+}
+
+void Selector::stopPolling() {
+    if (polledWakeup) {
+        stopPollingWakeup(*polledWakeup);
+        polledWakeup = 0;
+    }
+}
+
+PollRecord* Selector::handleOtherwise(PollRecord* fallback, bool checkFiles) {
+    // First give the other events one last chance.  Files are polled without
+    // blocking.
+    if (checkFiles) {
+        const TimePoint immediately;  // long past
+        if (const int numReady =
+                poller->wait(&readyEvents.front(), &immediately)) {
+            PollRecord* const winner = handleFileEvent(numReady);
+            if (winner != records.end()) {
+                return winner;
+            }
+        }
+    }
+
+    if (!timers.empty()) {
+        PollRecord* const winner = handleTimeout();
+        if (winner != records.end()) {
+            return winner;
+        }
+    }
+
+    // Nothing else was ready, so fulfill `fallback`.
+    PollRecord* winner = claim();
+    if (winner != records.end()) {
+        return winner;
+    }
+
+    fallback->ioEvent = fallback->event.fulfill(fallback->ioEvent);
+    winner            = checkForFulfillment(fallback);
+    if (winner == records.end()) {
+        watch(fallback);
+    }
+
+    return winner;
+}
+
+void Selector::discardStaleTimers() {
+    while (!timers.empty()) {
+        const TimerEntry& top    = timers.front();
+        const PollRecord& record = records[top.position];
+        if (record.state == PollRecord::ACTIVE && record.ioEvent.timeout &&
+            record.timerSequence == top.sequence) {
+            return;  // `top` is current
+        }
+
+        std::pop_heap(timers.begin(), timers.end(), LaterExpiration());
+        timers.pop_back();
+    }
+}
+
+PollRecord* Selector::handleTimeout() {
+    const TimePoint after = now();
+
+    // Entries pushed while handling this timeout are left for next time, even
+    // if they've already expired, so that an event that keeps returning
+    // expired timeouts can't keep us here forever.
+    const unsigned limit = nextTimerSequence;
+
+    for (discardStaleTimers(); !timers.empty(); discardStaleTimers()) {
+        const TimerEntry& top = timers.front();
+        if (top.expiration > after || top.sequence >= limit) {
+            break;  // nothing else has expired yet
+        }
+
+        PollRecord* const it = records.begin() + top.position;
+        std::pop_heap(timers.begin(), timers.end(), LaterExpiration());
+        timers.pop_back();
+
+        // We found one of the events that expired.  Try to fulfill it.
+        PollRecord* winner = claim();
+        if (winner != records.end()) {
+            return winner;
+        }
+
+        PollRecord& record = *it;
+        record.ioEvent     = record.event.fulfill(record.ioEvent);
+        winner             = checkForFulfillment(it);
+        if (winner != records.end()) {
+            return winner;
+        }
+
+        watch(it);
+    }
+
+    return records.end();  // no winner yet
+}
+
+PollRecord* Selector::handleFileEvent(int numReady) {
+    // Only the records that `poller` reported as ready are visited.  `poller`
+    // reports them in argument order, so start at a random one for the same
+    // reason that `records` is shuffled.
+    ThreadRandom15 generator;
+    const int      start = randomInt(0, numReady - 1, generator);
+    for (int n = 0; n < numReady; ++n) {
+        const PollerEvent& ready  = readyEvents[(start + n) % numReady];
+        PollRecord* const  it     = records.begin() + positions[ready.key];
+        PollRecord&        record = *it;
+
+        // Before calling `fulfill()` on the event, possibly set response-only
+        // flags on the related `IoEvent`, so that `fulfill()` has that
+        // information.
+        IoEvent& ioEvent = record.ioEvent;
+
+        if (ready.revents & POLLHUP) {
+            ioEvent.hangup = true;
+        }
+        if (ready.revents & POLLERR) {
+            ioEvent.error = true;
+        }
+        if (ready.revents & POLLNVAL) {
+            ioEvent.invalid = true;
+        }
+
+        PollRecord* winner = claim();
+        if (winner != records.end()) {
+            return winner;
+        }
+
+        ioEvent = record.event.fulfill(record.ioEvent);
+        winner  = checkForFulfillment(it);
+        if (winner != records.end()) {
+            return winner;
+        }
+
+        watch(it);
+    }
+
+    return records.end();  // no winner yet
+}
+
+Error Selector::handleError(const Error& originalError) {
+    // Mark our `SelectorFulfillment` as `UNFULFILLABLE` so that, even though
+    // we likely did not fulfill any event, nobody will try to interact with
+    // our events after we've been destroyed.  If the error came from an event
+    // that was being called, then we might still have a claim on it.
+    const bool holdingClaim =
+        claimed && fulfillment->fulfilledEventKey(generation) ==
+                       SelectorFulfillment::CLAIMED;
+    claimed = false;
+    fulfillment->forbid(holdingClaim);
+
+    // To clean up, call `cancel` on any `PollRecord` currently in the `ACTIVE`
+    // state.  However, doing so could throw an exception, so possibly append
+    // error messages as we go.
+    bool caughtAnotherOne = false;
+
+    Error combinedError(ErrorCode::SELECT_UNWINDING);
+    combinedError.appendMessage(originalError.what());
+
+    for (PollRecord* it = records.begin(); it != records.end(); ++it) {
+        PollRecord& record = *it;
+
+        if (record.state != PollRecord::ACTIVE) {
+            continue;
+        }
+
+        try {
+            record.event.cancel(record.ioEvent);
+        }
+        catch (const std::exception& anotherError) {
+            caughtAnotherOne = true;
+            combinedError.appendMessage(anotherError.what());
+        }
+        catch (...) {
+            caughtAnotherOne = true;
+            combinedError.appendMessage(ErrorCode(ErrorCode::OTHER).message());
+        }
+    }
+
+    stopPolling();
+
+    if (caughtAnotherOne) {
+        return combinedError;
+    }
+    else {
+        return originalError;
+    }
+}
+
+}  // namespace chan
@@ -0,0 +1,223 @@
+#ifndef INCLUDED_CHAN_SELECT_SELECTOR
+#define INCLUDED_CHAN_SELECT_SELECTOR
+
+// This component provides `Selector`, the machinery behind `chan::select`.
+// A `Selector` holds a sequence of events, and each invocation of its
+// `operator()` waits until one of them is fulfilled.
+//
+// A `Selector` may be invoked more than once.  Its storage, its `Poller`, and
+// its `SelectorFulfillment` are reused from one invocation to the next, so
+// that a `Selector` kept alive across iterations of a loop (see
+// `chan/select/selectset.h`) does no allocation and no redundant setup once
+// it has reached a steady state.
+//
+// A `Selector` having no more than `CHAN_MAX_ARITY` events, which includes
+// every `Selector` created by `chan::select`, stores all of its per-call state
+// within itself, and so does not allocate memory when it lives on the stack.
+// Its `SelectorFulfillment` comes from a pool kept by each thread (see
+// `chan/select/fulfillmentpool.h`), so a `Selector` need not allocate one
+// either.
+//
+// Channel events wait on their thread's `ThreadWakeup` (see
+// `chan/files/threadwakeup.h`) rather than on a file of their own.  If no
+// event of a selection watches any other file, then the `Selector` waits on
+// the `ThreadWakeup` directly (a `futex` wait, on Linux), and doesn't use its
+// `Poller` at all.  Otherwise, it has the `ThreadWakeup`'s file polled along
+// with the others.
+
+#include <chan/event/eventcontext.h>
+#include <chan/event/eventref.h>
+#include <chan/event/ioevent.h>
+#include <chan/macros/macros.h>
+#include <chan/select/epollpoller.h>
+#include <chan/select/inlinevector.h>
+#include <chan/select/poller.h>
+#include <chan/select/pollpoller.h>
+#include <chan/select/selectbackend.h>
+#include <chan/select/uringpoller.h>
+#include <chan/time/timepoint.h>
+
+namespace chan {
+
+class Error;
+struct ThreadWakeup;
+
+struct PollRecord {
+    // the zero-based position of `event` among the arguments to `select`
+    int argumentIndex;
+
+    // the corresponding event
+    EventRef event;
+
+    // the most recent `IoEvent` returned by `event`
+    IoEvent ioEvent;
+
+    // This `state` is used for error handling.  We need to keep track of which
+    // events need to be "cleaned up" when something else throws an exception.
+    enum State { UNINITIALIZED, ACTIVE, DONE } state;
+
+    // the `sequence` of the most recent `TimerEntry` referring to this record,
+    // or zero if there is none
+    unsigned timerSequence;
+
+    PollRecord(EventRef event, int argumentIndex)
+    : argumentIndex(argumentIndex)
+    , event(event)
+    , ioEvent()
+    , state(UNINITIALIZED)
+    , timerSequence(0) {
+    }
+};
+
+// A `TimerEntry` is an element of the min-heap of expirations that a
+// `Selector` keeps for its timeout `IoEvent`s.  Entries are not removed when
+// their record's `IoEvent` changes.  Instead, an entry is ignored unless its
+// `sequence` matches its record's `timerSequence`.
+struct TimerEntry {
+    // when the record's timeout `IoEvent` expires
+    TimePoint expiration;
+
+    // the position of the record within `Selector::records`
+    int position;
+
+    // distinguishes this entry from earlier entries for the same record
+    unsigned sequence;
+};
+
+// A `Selector` is the object that holds all of the state during a call to
+// `chan::select`.
+class Selector {
+    // `events` are in argument order.  `records` are made from `events` at
+    // the beginning of each selection, and then shuffled to enforce some
+    // kind of fairness.  After shuffling, the position of each `PollRecord`
+    // within `records` is its `EventKey`, while its argument index is its key
+    // within `poller`.  `positions` maps argument indices to positions within
+    // `records`.
+    InlineVector<EventRef, CHAN_MAX_ARITY>    events;
+    InlineVector<PollRecord, CHAN_MAX_ARITY>  records;
+    InlineVector<int, CHAN_MAX_ARITY>         positions;
+    InlineVector<PollerEvent, CHAN_MAX_ARITY> readyEvents;
+
+    // `fulfillment` is allocated from the thread's pool (see
+    // `chan/select/fulfillmentpool.h`) by the first selection, or is null
+    // before then, and `generation` is the current selection's.
+    SelectorFulfillment* fulfillment;
+    unsigned             generation;
+
+    // `timers` is a min-heap, ordered by expiration, of the records whose
+    // `IoEvent`s are timeouts, so that neither finding the next deadline nor
+    // finding expired timeouts requires visiting every record.
+    // `nextTimerSequence` is the `sequence` of the next `TimerEntry` pushed.
+    InlineVector<TimerEntry, CHAN_MAX_ARITY> timers;
+    unsigned                                 nextTimerSequence;
+
+    // `poller` refers to whichever of the following is in use, or is null if
+    // none has been prepared for the current number of `events`.
+    PollPoller pollPoller;
+#ifdef CHAN_HAS_EPOLL
+    EpollPoller epollPoller;
+#endif
+#ifdef CHAN_HAS_IO_URING
+    UringPoller uringPoller;
+#endif
+    Poller* poller;
+
+    // the number of selections, including any in progress, since events were
+    // last appended or removed
+    int numSelections;
+
+    // whether any record of the current selection has watched the thread's
+    // `ThreadWakeup` (i.e. a notification file), and whether any has watched
+    // some other file, respectively
+    bool watchingWakeup;
+    bool watchingFiles;
+
+    // the thread's `ThreadWakeup` if the current selection had to start
+    // polling it, or otherwise null
+    ThreadWakeup* polledWakeup;
+
+    // whether `fulfillment` was claimed (see `chan/event/eventcontext.h`) on
+    // behalf of an event that's being called
+    bool claimed;
+
+    Selector(const Selector&) /* = delete */;
+    Selector& operator=(const Selector&) /* = delete */;
+
+    // The following functions return an iterator to the "winner" (event that
+    // was fulfilled), or otherwise to `records.end()` if there was no winner.
+    //
+    // `claim` claims `fulfillment` before an event's `file` or `fulfill` is
+    // called, so that no other `select` fulfills one of our events meanwhile,
+    // and `checkForFulfillment` gives up the claim afterward.  `remoteWinner`
+    // returns the event that another `select` fulfilled.
+    PollRecord* claim();
+    PollRecord* checkForFulfillment(PollRecord* recordIter);
+    PollRecord* remoteWinner();
+    PollRecord* doPoll();
+    PollRecord* handleTimeout();
+    PollRecord* handleFileEvent(int numReady);
+
+    // Block until something that the records are watching happens, or until
+    // the optionally specified `deadline`, and then write into `readyEvents`
+    // the keys that might be ready.  Return the number written, as
+    // `Poller::wait` does.  `fulfillment` must not be claimed.
+    int wait(const TimePoint* deadline);
+
+    // If `polledWakeup` isn't null, stop polling it.
+    void stopPolling();
+
+    // Without waiting, check whether any file event or timeout is ready, and
+    // if none is fulfilled, fulfill the record at the specified `fallback`,
+    // which is an `otherwise` event.  If the specified `checkFiles` is
+    // `false`, then no event is watching a file other than a notification
+    // file (see `IoEvent::notification`), so don't poll.
+    PollRecord* handleOtherwise(PollRecord* fallback, bool checkFiles);
+
+    // Tell `poller` (or `timers`) what to wait for on behalf of the record at
+    // the specified `recordIter`, based on the record's most recent `IoEvent`.
+    void watch(PollRecord* recordIter);
+
+    // Remove from the top of `timers` any entries that no longer correspond
+    // to their records' current `IoEvent`s.
+    void discardStaleTimers();
+
+    // Prepare `records`, `readyEvents`, `fulfillment`, and `poller` for a new
+    // selection, reusing whatever can be reused.
+    void prepare();
+
+    Error handleError(const Error& caughtError);
+
+  public:
+    // Create a `Selector` having no events.
+    Selector();
+
+    // Create a `Selector` having the events in the specified range
+    // `[events, end)`.  Call `touch` on each event.
+    Selector(EventRef* events, const EventRef* end);
+
+    ~Selector();
+
+    // Append the specified `event` to the events of this `Selector`, and call
+    // `touch` on it.
+    void append(EventRef event);
+
+    // Replace the event at the specified argument `index` with the specified
+    // `event`, and call `touch` on it.  The behavior is undefined unless
+    // `0 <= index < size()`.
+    void replace(int index, EventRef event);
+
+    // Remove all events.
+    void clear();
+
+    // Return the number of events.
+    int size() const;
+
+    // `operator()` does the selecting, returning the index of the first
+    // fulfilled event, or otherwise a negative error code.  The behavior is
+    // undefined unless `size() > 0`.
+    int operator()();
+};
+
+}  // namespace chan
+
+#endif
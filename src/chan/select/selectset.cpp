@@ -0,0 +1,37 @@
+#include <chan/select/selectset.h>
+
+namespace chan {
+
+SelectSetEntry::~SelectSetEntry() {
+}
+
+SelectSet::SelectSet()
+: entries()
+, selector() {
+}
+
+SelectSet::~SelectSet() {
+    clear();
+}
+
+void SelectSet::clear() {
+    selector.clear();
+
+    for (std::vector<SelectSetEntry*>::iterator it = entries.begin();
+         it != entries.end();
+         ++it) {
+        delete *it;
+    }
+
+    entries.clear();
+}
+
+int SelectSet::size() const {
+    return entries.size();
+}
+
+int SelectSet::select() {
+    return selector();
+}
+
+}  // namespace chan
@@ -0,0 +1,180 @@
+#ifndef INCLUDED_CHAN_SELECT_SELECTSET
+#define INCLUDED_CHAN_SELECT_SELECTSET
+
+// This component provides `SelectSet`, a long-lived collection of events that
+// can be selected upon repeatedly.  Where
+//
+//     for (;;) {
+//         switch (chan::select(input.read(), ticks.recv(&tick))) {
+//             // ...
+//         }
+//     }
+//
+// sets up a new selection from scratch on every iteration,
+//
+//     chan::SelectSet selectSet;
+//     selectSet.add(input.read());
+//     selectSet.add(ticks.recv(&tick));
+//
+//     for (;;) {
+//         switch (selectSet.select()) {
+//             // ...
+//         }
+//     }
+//
+// keeps its events, its storage, its registrations with the system IO
+// multiplexing facility, and its fulfillment state from one iteration to the
+// next.  Once the loop has reached a steady state, it does no allocations,
+// and files are registered again only if an event starts waiting on
+// something different.
+//
+// An event whose work is finished, e.g. a deadline that has passed or a write
+// whose buffer has been written, can be swapped for a fresh one using `set`.
+// If the fresh event has the same type as the old one, then `set` reuses the
+// old event's storage.
+//
+// `SelectSet` stores copies of the events given to it.  Any objects to which
+// those events refer (e.g. the `Chan` in `ticks.recv(&tick)`, or `tick`
+// itself) must outlive the `SelectSet`.
+
+#include <chan/event/eventref.h>
+#include <chan/select/selector.h>
+
+#include <cassert>
+#include <new>
+#include <vector>
+
+namespace chan {
+
+// `SelectSetEntry` is an implementation detail of `SelectSet`.  It owns a copy
+// of an event of any type.
+class SelectSetEntry {
+  public:
+    virtual ~SelectSetEntry();
+
+    // Return a reference to the owned event.
+    virtual EventRef event() = 0;
+
+    // Return a value that is distinct for each type of event.
+    virtual const void* type() const = 0;
+};
+
+template <typename EVENT>
+class SelectSetEntryImpl : public SelectSetEntry {
+    union {
+        char buffer[sizeof(EVENT)];
+        // The following union members are included to ensure that `buffer`
+        // is adequately aligned for `EVENT` (see `chan/select/lasterror.cpp`).
+        long double dummyLd;
+        double      dummyD;
+        void*       dummyP;
+        long        dummyLi;
+    };
+
+    EVENT* instance;
+
+  public:
+    explicit SelectSetEntryImpl(const EVENT& original)
+    : instance(new (buffer) EVENT(original)) {
+        // The copy belongs to a `SelectSet` now, so it must never `select` on
+        // its own (e.g. in its destructor).
+        instance->touch();
+    }
+
+    ~SelectSetEntryImpl() {
+        instance->~EVENT();
+    }
+
+    // Destroy the owned event and replace it with a copy of the specified
+    // `original`.
+    void assign(const EVENT& original) {
+        instance->~EVENT();
+        instance = new (buffer) EVENT(original);
+        instance->touch();  // see the constructor
+    }
+
+    EventRef event() {
+        return EventRef(*instance);
+    }
+
+    const void* type() const {
+        return &EventRefVtableImpl<EVENT>::vtable;
+    }
+};
+
+class SelectSet {
+    std::vector<SelectSetEntry*> entries;
+    Selector                     selector;
+
+    SelectSet(const SelectSet&) /* = delete */;
+    SelectSet& operator=(const SelectSet&) /* = delete */;
+
+  public:
+    SelectSet();
+    ~SelectSet();
+
+    // Add a copy of the specified `event` to this set.  Return the index of
+    // the event, which is the value that `select` will return when the event
+    // is fulfilled.  Indices are assigned in order, starting with zero.
+    template <typename EVENT>
+    int add(const EVENT& event);
+
+    // Replace the event at the specified `index` with a copy of the specified
+    // `event`.  The behavior is undefined unless `0 <= index < size()`.
+    template <typename EVENT>
+    void set(int index, const EVENT& event);
+
+    // Remove all events from this set.
+    void clear();
+
+    // Return the number of events in this set.
+    int size() const;
+
+    // Wait until any of the events in this set is fulfilled and return its
+    // index.  If an error occurs, return a negative value indicating the kind
+    // of error (see `chan/errors/errorcode.h`), and record the error so that
+    // it is available from `lastError()`.  The behavior is undefined unless
+    // `size() > 0`.
+    int select();
+};
+
+template <typename EVENT>
+int SelectSet::add(const EVENT& event) {
+    SelectSetEntryImpl<EVENT>* const entry =
+        new SelectSetEntryImpl<EVENT>(event);
+
+    try {
+        entries.push_back(entry);
+    }
+    catch (...) {
+        delete entry;
+        throw;
+    }
+
+    selector.append(entry->event());
+    return entries.size() - 1;
+}
+
+template <typename EVENT>
+void SelectSet::set(int index, const EVENT& event) {
+    assert(index >= 0);
+    assert(index < size());
+
+    SelectSetEntry*& entry = entries[index];
+    if (entry->type() == &EventRefVtableImpl<EVENT>::vtable) {
+        // Same type of event, so reuse the storage.
+        static_cast<SelectSetEntryImpl<EVENT>*>(entry)->assign(event);
+    }
+    else {
+        SelectSetEntry* const replacement =
+            new SelectSetEntryImpl<EVENT>(event);
+        delete entry;
+        entry = replacement;
+    }
+
+    selector.replace(index, entry->event());
+}
+
+}  // namespace chan
+
+#endif
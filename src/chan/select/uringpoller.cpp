@@ -0,0 +1,378 @@
+#include <chan/select/uringpoller.h>
+
+#ifdef CHAN_HAS_IO_URING
+
+#include <chan/errors/error.h>
+#include <chan/errors/errorcode.h>
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>  // std::memset
+
+namespace chan {
+namespace {
+
+// The `user_data` of a poll request encodes the key on whose behalf it was
+// made in its upper half and the key's `sequence` in its lower half.
+// Cancellations are tagged with `cancelTag`, whose key is never valid.
+const __u64 cancelTag = ~__u64(0);
+
+__u64 tag(int key, unsigned sequence) {
+    return (static_cast<__u64>(key) << 32) | sequence;
+}
+
+// Return the subset of the specified `revents` that is relevant to a key
+// watching for the specified `events`.  Errors and hangups are always
+// relevant, as they are with `::poll`.
+short relevant(short revents, short events) {
+    return revents & (events | POLLERR | POLLHUP | POLLNVAL);
+}
+
+// The ring's head and tail indices are shared with the kernel, which might
+// be modifying them concurrently.
+unsigned loadAcquire(const unsigned* index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* index, unsigned value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+void* map(int ringFd, std::size_t size, off_t offset) {
+    void* const address = ::mmap(0,
+                                 size,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE,
+                                 ringFd,
+                                 offset);
+    return address == MAP_FAILED ? 0 : address;
+}
+
+unsigned* at(void* ring, unsigned offset) {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+}  // unnamed namespace
+
+UringPoller::UringPoller()
+: ringFd(-1)
+, ring(0)
+, ringSize(0)
+, sqes(0)
+, sqesSize(0)
+, sqHead(0)
+, sqTail(0)
+, sqArray(0)
+, sqMask(0)
+, sqEntries(0)
+, cqHead(0)
+, cqTail(0)
+, cqMask(0)
+, cqes(0)
+, keys()
+, nextSequence(1)
+, suspects()
+, suspectFds() {
+}
+
+UringPoller::~UringPoller() {
+    close();
+}
+
+bool UringPoller::open(int numKeys) {
+    // The submission queue needn't have room for every key, since `nextSqe`
+    // submits whenever it fills up, but that costs a system call.
+    unsigned entries = 64;
+    while (entries < unsigned(numKeys) && entries < 4096) {
+        entries *= 2;
+    }
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    ringFd = ::syscall(__NR_io_uring_setup, entries, &params);
+    if (ringFd == -1) {
+        return false;  // e.g. old kernel, or `io_uring` is disabled
+    }
+
+    // `IORING_FEAT_EXT_ARG` (Linux 5.11) implies the other two.
+    const unsigned required =
+        IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP | IORING_FEAT_SINGLE_MMAP;
+    if ((params.features & required) != required) {
+        close();
+        return false;
+    }
+
+    // With `IORING_FEAT_SINGLE_MMAP`, both rings live in one mapping.
+    const std::size_t sqSize =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const std::size_t cqSize =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    ringSize = sqSize > cqSize ? sqSize : cqSize;
+    ring     = map(ringFd, ringSize, IORING_OFF_SQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes =
+        static_cast<io_uring_sqe*>(map(ringFd, sqesSize, IORING_OFF_SQES));
+    if (!ring || !sqes) {
+        close();
+        return false;
+    }
+
+    sqHead    = at(ring, params.sq_off.head);
+    sqTail    = at(ring, params.sq_off.tail);
+    sqArray   = at(ring, params.sq_off.array);
+    sqMask    = *at(ring, params.sq_off.ring_mask);
+    sqEntries = *at(ring, params.sq_off.ring_entries);
+    cqHead    = at(ring, params.cq_off.head);
+    cqTail    = at(ring, params.cq_off.tail);
+    cqMask    = *at(ring, params.cq_off.ring_mask);
+    cqes      = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(ring) +
+                                           params.cq_off.cqes);
+
+    return true;
+}
+
+void UringPoller::close() {
+    if (sqes) {
+        ::munmap(sqes, sqesSize);
+        sqes = 0;
+    }
+    if (ring) {
+        ::munmap(ring, ringSize);
+        ring = 0;
+    }
+    if (ringFd != -1) {
+        ::close(ringFd);
+        ringFd = -1;
+    }
+}
+
+bool UringPoller::reset(int numKeys) {
+    // Cancel whatever the previous keys were waiting on.  The cancellations
+    // are submitted with the next `wait`, and any completions of the
+    // cancelled requests are then ignored, because the key or the sequence
+    // number won't match.
+    for (std::size_t key = 0; isOpen() && key < keys.size(); ++key) {
+        watch(key, -1, 0);
+    }
+
+    const KeyEntry unused = { -1, 0, 0 };
+    keys.assign(numKeys, unused);
+    suspects.clear();
+    suspectFds.clear();
+
+    return isOpen() || open(numKeys);
+}
+
+bool UringPoller::isOpen() const {
+    return ringFd != -1;
+}
+
+io_uring_sqe* UringPoller::nextSqe() {
+    // Only this object writes to `*sqTail`, so it can be read plainly.
+    const unsigned tail = *sqTail;
+    while (tail - loadAcquire(sqHead) == sqEntries) {
+        enter(0, 0);
+    }
+
+    const unsigned index = tail & sqMask;
+    sqArray[index]       = index;
+    io_uring_sqe* sqe    = &sqes[index];
+    std::memset(sqe, 0, sizeof *sqe);
+    return sqe;
+}
+
+void UringPoller::queuePoll(int key) {
+    KeyEntry& entry = keys[key];
+    assert(entry.file != -1);
+
+    entry.sequence = nextSequence++;
+    if (nextSequence == 0) {
+        nextSequence = 1;  // zero means "no request"
+    }
+
+    io_uring_sqe* const sqe = nextSqe();
+    sqe->opcode             = IORING_OP_POLL_ADD;
+    sqe->fd                 = entry.file;
+    sqe->poll32_events      = static_cast<unsigned short>(entry.events);
+    sqe->user_data          = tag(key, entry.sequence);
+
+    storeRelease(sqTail, *sqTail + 1);
+}
+
+void UringPoller::queueCancel(int key) {
+    KeyEntry& entry = keys[key];
+    assert(entry.sequence);
+
+    io_uring_sqe* const sqe = nextSqe();
+    sqe->opcode             = IORING_OP_POLL_REMOVE;
+    sqe->fd                 = -1;
+    sqe->addr               = tag(key, entry.sequence);
+    sqe->user_data          = cancelTag;
+    entry.sequence          = 0;
+
+    storeRelease(sqTail, *sqTail + 1);
+}
+
+void UringPoller::watch(int key, int file, short events) {
+    assert(isOpen());
+    assert(key >= 0);
+    assert(key < int(keys.size()));
+
+    if (file < 0) {
+        file   = -1;
+        events = 0;
+    }
+
+    KeyEntry& entry = keys[key];
+    if (entry.file == file && entry.events == events) {
+        return;  // already watching exactly this
+    }
+
+    if (entry.sequence) {
+        queueCancel(key);
+    }
+
+    entry.file   = file;
+    entry.events = events;
+    if (file != -1) {
+        queuePoll(key);
+    }
+}
+
+void UringPoller::enter(unsigned minComplete, const TimePoint* deadline) {
+    // The timeout is relative, as with `ppoll`.
+    timespec               buffer;
+    __kernel_timespec      timeout;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof arg);
+    if (timeoutTimespec(deadline, &buffer)) {
+        timeout.tv_sec  = buffer.tv_sec;
+        timeout.tv_nsec = buffer.tv_nsec;
+        arg.ts          = reinterpret_cast<unsigned long>(&timeout);
+    }
+
+    unsigned flags = IORING_ENTER_EXT_ARG;
+    if (minComplete) {
+        flags |= IORING_ENTER_GETEVENTS;
+    }
+
+    const unsigned toSubmit = *sqTail - loadAcquire(sqHead);
+    if (::syscall(__NR_io_uring_enter,
+                  ringFd,
+                  toSubmit,
+                  minComplete,
+                  flags,
+                  &arg,
+                  sizeof arg) != -1) {
+        return;
+    }
+
+    const int errorCode = errno;
+    switch (errorCode) {
+        case EINTR:  // signal was caught; fine, nothing is ready
+        case ETIME:  // the deadline arrived
+        case EBUSY:  // completions must be consumed first, which `wait` does
+        case EAGAIN:
+            return;
+        default:
+            throw Error(ErrorCode::POLL, errorCode);
+    }
+}
+
+void UringPoller::reap() {
+    unsigned       head = *cqHead;
+    const unsigned tail = loadAcquire(cqTail);
+
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe  = cqes[head & cqMask];
+        const __u64         data = cqe.user_data;
+        const __u64         key  = data >> 32;
+
+        if (key >= keys.size()) {
+            continue;  // e.g. a cancellation
+        }
+
+        KeyEntry& entry = keys[key];
+        if (entry.sequence != unsigned(data)) {
+            continue;  // a cancelled request; the key has moved on
+        }
+
+        entry.sequence = 0;
+
+        pollfd fd;
+        fd.fd      = entry.file;
+        fd.events  = entry.events;
+        fd.revents = cqe.res >= 0          ? short(cqe.res)
+                     : cqe.res == -EBADF ? short(POLLNVAL)
+                                         : short(POLLERR);
+
+        suspects.push_back(key);
+        suspectFds.push_back(fd);
+    }
+
+    storeRelease(cqHead, head);
+}
+
+void UringPoller::confirm() {
+    for (std::size_t i = 0; i < suspectFds.size(); ++i) {
+        suspectFds[i].revents = 0;
+    }
+
+    // If a signal interrupts, then none of them is considered ready.
+    ::poll(&suspectFds.front(), suspectFds.size(), 0);
+}
+
+int UringPoller::report(PollerEvent* ready) {
+    int numReady = 0;
+    for (std::size_t i = 0; i < suspects.size(); ++i) {
+        const int key = suspects[i];
+        if (const short flags =
+                relevant(suspectFds[i].revents, keys[key].events)) {
+            ready[numReady].key     = key;
+            ready[numReady].revents = flags;
+            ++numReady;
+        }
+
+        // Poll again, so that the next `wait` sees the file's next change.
+        // The request is submitted by that `wait`, at which point the kernel
+        // completes it immediately if the file is still ready.
+        queuePoll(key);
+    }
+
+    suspects.clear();
+    suspectFds.clear();
+    return numReady;
+}
+
+int UringPoller::wait(PollerEvent* ready, const TimePoint* deadline) {
+    assert(isOpen());
+    assert(ready);
+
+    // Completions that arrived since the previous `wait` returned might be
+    // stale, so confirm them before reporting them.
+    reap();
+    if (!suspects.empty()) {
+        confirm();
+        if (const int numReady = report(ready)) {
+            return numReady;
+        }
+    }
+
+    // Nothing is ready now.  Submit the queued requests and wait.
+    // Completions that arrive during `io_uring_enter` are as current as what
+    // `::poll` would have reported.
+    enter(1, deadline);
+    reap();
+    return report(ready);
+}
+
+}  // namespace chan
+
+#endif  // #ifdef CHAN_HAS_IO_URING
@@ -0,0 +1,146 @@
+#ifndef INCLUDED_CHAN_SELECT_URINGPOLLER
+#define INCLUDED_CHAN_SELECT_URINGPOLLER
+
+// `UringPoller` is an implementation of the `Poller` protocol that uses Linux
+// `io_uring`.  Each watched file has a one-shot poll request outstanding in
+// the kernel.  Requests are queued in memory shared with the kernel, and
+// `wait` submits all of the queued requests and waits for completions in a
+// single `io_uring_enter` system call.  A request is resubmitted only after
+// it completes or after its key starts watching something else, so a
+// `SelectSet` that selects repeatedly on the same files pays, per selection,
+// for one system call and for the files that were actually ready.
+//
+// A one-shot poll request completes when its file becomes ready, but the file
+// might be unready again by the time the completion is looked at (e.g.
+// somebody else read from it in the meantime).  `::poll` and `epoll` can't
+// report such stale readiness, since they check each file when asked, and the
+// rest of `chan::select` relies on that.  So, completions that arrive between
+// calls to `wait` are confirmed with a non-blocking `::poll` of just those
+// files before they are reported.
+//
+// Only readiness is delegated to `io_uring`.  The reads and writes themselves
+// remain with the events that perform them (see `chan/event/README.md`).
+//
+// `UringPoller` requires Linux 5.11 or later, for `IORING_FEAT_EXT_ARG`
+// (timeouts passed directly to `io_uring_enter`).  On older kernels, or where
+// `io_uring` is disabled, `reset` fails and `select` falls back to `::poll`.
+//
+// This component is empty unless `CHAN_HAS_IO_URING` is defined (see
+// `chan/select/selectbackend.h`).
+
+#include <chan/select/poller.h>
+#include <chan/select/selectbackend.h>
+
+#ifdef CHAN_HAS_IO_URING
+
+#include <poll.h>
+
+#include <cstddef>  // std::size_t
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace chan {
+
+class UringPoller : public Poller {
+    struct KeyEntry {
+        int   file;  // negative if the key isn't watching anything
+        short events;
+
+        // the sequence number of this key's queued or outstanding poll
+        // request, or zero if there is none.  Completions are checked against
+        // it so that those of cancelled requests can be ignored.
+        unsigned sequence;
+    };
+
+    int ringFd;
+
+    // the memory shared with the kernel, as mapped by `open`.  `ring`
+    // contains both the submission queue and the completion queue.
+    void*         ring;
+    std::size_t   ringSize;
+    io_uring_sqe* sqes;
+    std::size_t   sqesSize;
+
+    // pointers into `ring`, and the sizes of the queues
+    unsigned*     sqHead;
+    unsigned*     sqTail;
+    unsigned*     sqArray;
+    unsigned      sqMask;
+    unsigned      sqEntries;
+    unsigned*     cqHead;
+    unsigned*     cqTail;
+    unsigned      cqMask;
+    io_uring_cqe* cqes;
+
+    std::vector<KeyEntry> keys;
+    unsigned              nextSequence;
+
+    // keys whose requests completed between calls to `wait`, and the
+    // `pollfd`s with which to confirm them
+    std::vector<int>    suspects;
+    std::vector<pollfd> suspectFds;
+
+    UringPoller(const UringPoller&) /* = delete */;
+    UringPoller& operator=(const UringPoller&) /* = delete */;
+
+    // Create the ring and map it into memory, with room for at least the
+    // specified `numKeys` requests.  Return whether the ring is usable.
+    bool open(int numKeys);
+    void close();
+
+    // Queue a request to poll the file watched on behalf of the specified
+    // `key`, or to cancel its outstanding request, respectively.
+    void queuePoll(int key);
+    void queueCancel(int key);
+
+    // Return a submission queue entry to fill in, submitting the queued
+    // requests first if the submission queue is full.
+    io_uring_sqe* nextSqe();
+
+    // Call `io_uring_enter` to submit the queued requests and then, if the
+    // specified `minComplete` is nonzero, to wait for that many completions
+    // or until the optionally specified `deadline`.  Throw an exception if an
+    // error occurs.
+    void enter(unsigned minComplete, const TimePoint* deadline);
+
+    // Consume the available completions, appending to `suspects` and
+    // `suspectFds` the keys whose current requests completed and the flags
+    // with which they completed.
+    void reap();
+
+    // Write into the specified `ready` those `suspects` whose `suspectFds`
+    // flags are relevant, requeue a poll request for each of the `suspects`,
+    // and clear them.  Return the number written.
+    int report(PollerEvent* ready);
+
+    // Replace the flags in `suspectFds` with the current readiness of their
+    // files, as reported by a non-blocking `::poll`.
+    void confirm();
+
+  public:
+    // Create a `UringPoller` having no keys and no ring.  Call `reset` before
+    // using it.
+    UringPoller();
+    ~UringPoller();
+
+    // Discard all keys, and then prepare to monitor files on behalf of the
+    // specified `numKeys` keys, none of which initially monitors any file.
+    // Create an `io_uring` instance if this object doesn't have one already.
+    // Return `true` on success, or return `false` if the system is unable to
+    // provide a suitable `io_uring` instance, in which case the behavior of
+    // `watch` and `wait` is undefined.
+    bool reset(int numKeys);
+
+    bool isOpen() const;
+
+    void watch(int key, int file, short events);
+    int  wait(PollerEvent* ready, const TimePoint* deadline);
+};
+
+}  // namespace chan
+
+#endif  // #ifdef CHAN_HAS_IO_URING
+
+#endif
@@ -1,62 +1,178 @@
-
-#include <chan/errors/error.h>
-#include <chan/threading/mutex.h>
-
-#include <cassert>
-#include <cerrno>
-#include <cstring>
-#include <stdexcept>
-
-#include <pthread.h>
-
-namespace chan {
-
-// `MutexImpl`, a component-private implementation class, is defined inline
-// here.  Definitions of member functions of the public class, `Mutex`,
-// follow.
-class MutexImpl {
-    pthread_mutex_t mutex;
-
-  public:
-    MutexImpl() {
-        if (const int rcode = pthread_mutex_init(&mutex, 0)) {
-            throw Error(ErrorCode::MUTEX_INIT, rcode);
-        }
-    }
-
-    ~MutexImpl() {
-        const int rc = pthread_mutex_destroy(&mutex);
-        assert(rc == 0);
-        (void)rc;
-    }
-
-    int lock() {
-        return pthread_mutex_lock(&mutex);
-    }
-
-    int unlock() {
-        return pthread_mutex_unlock(&mutex);
-    }
-};
-
-Mutex::Mutex()
-: d_impl_p(new MutexImpl) {
-}
-
-Mutex::~Mutex() {
-    delete d_impl_p;
-}
-
-void Mutex::lock() {
-    if (const int rcode = d_impl_p->lock()) {
-        throw Error(ErrorCode::MUTEX_LOCK, rcode);
-    }
-}
-
-void Mutex::unlock() {
-    if (const int rcode = d_impl_p->unlock()) {
-        throw Error(ErrorCode::MUTEX_UNLOCK, rcode);
-    }
-}
-
-}  // namespace chan
+#include <chan/errors/error.h>
+#include <chan/threading/mutex.h>
+
+#include <unistd.h>  // sysconf
+
+#ifdef CHAN_HAS_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <cerrno>
+#endif
+
+#include <cassert>
+
+namespace chan {
+namespace {
+
+// A contended `lock` spins at most this many times before sleeping, and no
+// more than twice as many times as it recently took, plus a few.
+const int maxSpins = 100;
+const int minSpins = 10;
+
+// Spinning is pointless if the holder of the lock can't run meanwhile.
+const bool isMultiprocessor = ::sysconf(_SC_NPROCESSORS_ONLN) > 1;
+
+// Tell the processor that this is a spin loop, if there's a way to.
+void relax() {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Nudge the specified `*estimate` toward the specified `spins`.
+void adapt(int* estimate, int spins) {
+    const int previous = __atomic_load_n(estimate, __ATOMIC_RELAXED);
+    __atomic_store_n(
+        estimate, previous + (spins - previous) / 8, __ATOMIC_RELAXED);
+}
+
+int spinLimit(const int* estimate) {
+    if (!isMultiprocessor) {
+        return 0;
+    }
+
+    const int limit = __atomic_load_n(estimate, __ATOMIC_RELAXED) * 2 +
+                      minSpins;
+    return limit < maxSpins ? limit : maxSpins;
+}
+
+#ifdef CHAN_MUTEX_STATS
+MutexStats stats;
+
+void count(unsigned long* counter) {
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+}  // unnamed namespace
+
+#ifdef CHAN_HAS_FUTEX
+
+void Mutex::lockContended() {
+#ifdef CHAN_MUTEX_STATS
+    count(&stats.contended);
+#endif
+
+    const int limit = spinLimit(&spinEstimate);
+    for (int spins = 0; spins < limit; ++spins) {
+        relax();
+        if (__atomic_load_n(&state, __ATOMIC_RELAXED) == UNLOCKED &&
+            tryLock()) {
+            adapt(&spinEstimate, spins);
+#ifdef CHAN_MUTEX_STATS
+            count(&stats.spun);
+#endif
+            return;
+        }
+    }
+
+    adapt(&spinEstimate, limit);
+#ifdef CHAN_MUTEX_STATS
+    count(&stats.slept);
+#endif
+
+    // Mark the `Mutex` as `CONTENDED`, so that whoever unlocks it wakes me.
+    // If it happened to be `UNLOCKED`, then I've acquired it instead, and it
+    // stays `CONTENDED` for as long as I hold it, which costs its next
+    // `unlock` a needless wake, but nothing worse.
+    while (__atomic_exchange_n(&state, CONTENDED, __ATOMIC_ACQUIRE) !=
+           UNLOCKED) {
+        // If the state is no longer `CONTENDED`, this returns immediately.
+        // Either way, try again.
+        ::syscall(
+            SYS_futex, &state, FUTEX_WAIT_PRIVATE, CONTENDED, 0, 0, 0);
+    }
+}
+
+void Mutex::wakeWaiter() {
+    ::syscall(SYS_futex, &state, FUTEX_WAKE_PRIVATE, 1, 0, 0, 0);
+}
+
+#else  // #ifdef CHAN_HAS_FUTEX
+
+Mutex::Mutex()
+: spinEstimate() {
+    if (const int rcode = pthread_mutex_init(&mutex, 0)) {
+        throw Error(ErrorCode::MUTEX_INIT, rcode);
+    }
+}
+
+Mutex::~Mutex() {
+    const int rc = pthread_mutex_destroy(&mutex);
+    assert(rc == 0);
+    (void)rc;
+}
+
+bool Mutex::tryLock() {
+    const int rcode = pthread_mutex_trylock(&mutex);
+    if (rcode == 0) {
+        return true;
+    }
+    else if (rcode == EBUSY) {
+        return false;
+    }
+
+    throw Error(ErrorCode::MUTEX_LOCK, rcode);
+}
+
+void Mutex::lockContended() {
+#ifdef CHAN_MUTEX_STATS
+    count(&stats.contended);
+#endif
+
+    const int limit = spinLimit(&spinEstimate);
+    for (int spins = 0; spins < limit; ++spins) {
+        relax();
+        if (tryLock()) {
+            adapt(&spinEstimate, spins);
+#ifdef CHAN_MUTEX_STATS
+            count(&stats.spun);
+#endif
+            return;
+        }
+    }
+
+    adapt(&spinEstimate, limit);
+#ifdef CHAN_MUTEX_STATS
+    count(&stats.slept);
+#endif
+
+    if (const int rcode = pthread_mutex_lock(&mutex)) {
+        throw Error(ErrorCode::MUTEX_LOCK, rcode);
+    }
+}
+
+void Mutex::unlock() {
+    if (const int rcode = pthread_mutex_unlock(&mutex)) {
+        throw Error(ErrorCode::MUTEX_UNLOCK, rcode);
+    }
+}
+
+#endif  // #ifdef CHAN_HAS_FUTEX
+
+#ifdef CHAN_MUTEX_STATS
+
+MutexStats mutexStats() {
+    MutexStats result;
+    result.contended = __atomic_load_n(&stats.contended, __ATOMIC_RELAXED);
+    result.spun      = __atomic_load_n(&stats.spun, __ATOMIC_RELAXED);
+    result.slept     = __atomic_load_n(&stats.slept, __ATOMIC_RELAXED);
+    return result;
+}
+
+#endif  // #ifdef CHAN_MUTEX_STATS
+
+}  // namespace chan
@@ -1,23 +1,111 @@
 #ifndef INCLUDED_CHAN_THREADING_MUTEX
 #define INCLUDED_CHAN_THREADING_MUTEX
 
+// `Mutex` is a non-recursive mutual exclusion lock that lives entirely within
+// the object that contains it, so creating one doesn't allocate.  The
+// critical sections that this library protects with a `Mutex` are very short,
+// so if the `Mutex` is locked, then `lock` first spins for a while, in the
+// hope that it will be unlocked soon, before putting the thread to sleep.
+// How long it spins adapts to how long it's recently had to spin in order to
+// acquire the `Mutex`.  On a machine with only one processor, it doesn't spin.
+//
+// On Linux, a `Mutex` is a word in memory, and a thread that has to sleep
+// waits on it using `futex`.  Elsewhere, or if `CHAN_NO_FUTEX` is defined, a
+// `Mutex` contains a `pthread_mutex_t`.
+//
+// If `CHAN_MUTEX_STATS` is defined, then every `Mutex` counts how often
+// `lock` found it locked, and how that ended, in process-wide counters that
+// are available from `mutexStats`.  Only the contended path of `lock` counts
+// anything, so counting doesn't slow down a `lock` that isn't contended.
+
+#if defined(__linux__) && !defined(CHAN_NO_FUTEX)
+#define CHAN_HAS_FUTEX 1
+#endif
+
+#ifndef CHAN_HAS_FUTEX
+#include <pthread.h>
+#endif
+
 namespace chan {
-class MutexImpl;
 
 class Mutex {
-    MutexImpl* d_impl_p;
+#ifdef CHAN_HAS_FUTEX
+    // `UNLOCKED`, `LOCKED`, or `CONTENDED` (locked, and somebody might be
+    // waiting in `futex`), only ever accessed atomically
+    int state;
+#else
+    pthread_mutex_t mutex;
+#endif
+    // recent number of spins needed to acquire this `Mutex`, only ever
+    // accessed atomically, but never mind the races
+    int spinEstimate;
 
     Mutex(const Mutex&) /* = delete */;
     Mutex& operator=(const Mutex&) /* = delete */;
 
+    // Acquire this `Mutex`, which was observed to be locked by somebody else.
+    void lockContended();
+
+#ifdef CHAN_HAS_FUTEX
+    enum State { UNLOCKED, LOCKED, CONTENDED };
+
+    // Wake up one thread waiting in `lockContended`.
+    void wakeWaiter();
+#endif
+
   public:
     Mutex();
     ~Mutex();
 
-    void lock();
+    // Acquire this `Mutex` if it's unlocked, and return whether it was.
+    bool tryLock();
+
+    void lock() {
+        if (!tryLock()) {
+            lockContended();
+        }
+    }
+
     void unlock();
 };
 
+#ifdef CHAN_HAS_FUTEX
+
+inline Mutex::Mutex()
+: state(UNLOCKED)
+, spinEstimate() {
+}
+
+inline Mutex::~Mutex() {
+}
+
+inline bool Mutex::tryLock() {
+    int expected = UNLOCKED;
+    return __atomic_compare_exchange_n(
+        &state, &expected, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+inline void Mutex::unlock() {
+    if (__atomic_exchange_n(&state, UNLOCKED, __ATOMIC_RELEASE) == CONTENDED) {
+        wakeWaiter();
+    }
+}
+
+#endif  // #ifdef CHAN_HAS_FUTEX
+
+#ifdef CHAN_MUTEX_STATS
+
+struct MutexStats {
+    unsigned long contended;  // calls to `lock` that found it locked
+    unsigned long spun;       // ... and then acquired it while spinning
+    unsigned long slept;      // ... or had to sleep at least once instead
+};
+
+// Return the process-wide counts of contention on every `Mutex` so far.
+MutexStats mutexStats();
+
+#endif  // #ifdef CHAN_MUTEX_STATS
+
 }  // namespace chan
 
 #endif
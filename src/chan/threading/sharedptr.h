@@ -2,36 +2,79 @@
 #define INCLUDED_CHAN_THREADING_SHAREDPTR
 
 // If C++11's `std::shared_ptr` is available, this is just a type alias.  If
-// it's not available, we can take a deep breath and use a mutex.
+// it's not available, `SharedPtr` is a minimal stand-in whose reference count
+// is changed using atomic builtins.
+//
+// `makeShared<OBJECT>()` and `makeShared<OBJECT>(argument)` create an
+// `OBJECT` and its reference count in one allocation, like
+// `std::make_shared`, which they are in C++11.
 
 #if __cplusplus >= 201103
 
 #include <memory>
+#include <utility>
 
 namespace chan {
 
 template <typename OBJECT>
 using SharedPtr = std::shared_ptr<OBJECT>;
 
+template <typename OBJECT, typename... ARGS>
+SharedPtr<OBJECT> makeShared(ARGS&&... args) {
+    return std::make_shared<OBJECT>(std::forward<ARGS>(args)...);
+}
+
 }  // namespace chan
 
 #else  // #if __cplusplus >= 201103
 
-#include <chan/threading/lockguard.h>
-#include <chan/threading/mutex.h>
-
 #include <algorithm>  // std::swap (C++98)
 #include <cassert>
 
 namespace chan {
 
+// A `SharedPtrControlBlock` counts the references to an object, and deleting
+// it destroys the object.
 struct SharedPtrControlBlock {
-    Mutex mutex;
-    int   referenceCount;
+    int referenceCount;  // only ever accessed atomically
 
     SharedPtrControlBlock()
     : referenceCount(1) {
     }
+
+    virtual ~SharedPtrControlBlock() {
+    }
+};
+
+// `SharedPtrOwner` manages an object allocated separately, as by
+// `SharedPtr(new OBJECT(...))`.
+template <typename OBJECT>
+class SharedPtrOwner : public SharedPtrControlBlock {
+    OBJECT* object;
+
+  public:
+    explicit SharedPtrOwner(OBJECT* object)
+    : object(object) {
+    }
+
+    ~SharedPtrOwner() {
+        delete object;
+    }
+};
+
+// `SharedPtrInPlace` contains its object, as created by `makeShared`.
+template <typename OBJECT>
+struct SharedPtrInPlace : public SharedPtrControlBlock {
+    OBJECT object;
+
+    SharedPtrInPlace()
+    : object() {
+    }
+
+    template <typename ARG>
+    explicit SharedPtrInPlace(const ARG& arg)
+    : object(arg) {
+    }
 };
 
 template <typename OBJECT>
@@ -39,26 +82,32 @@ class SharedPtr {
     OBJECT*                object;
     SharedPtrControlBlock* controlBlock;
 
+    template <typename OTHER>
+    friend SharedPtr<OTHER> makeShared();
+
+    template <typename OTHER, typename ARG>
+    friend SharedPtr<OTHER> makeShared(const ARG&);
+
+    SharedPtr(OBJECT* object, SharedPtrControlBlock* controlBlock)
+    : object(object)
+    , controlBlock(controlBlock) {
+    }
+
     void incrementRefCount() {
         if (controlBlock) {
-            LockGuard lock(controlBlock->mutex);
-            ++controlBlock->referenceCount;
+            // A new reference is made from an existing one, which keeps the
+            // object alive meanwhile, so there's nothing to synchronize with.
+            __atomic_add_fetch(
+                &controlBlock->referenceCount, 1, __ATOMIC_RELAXED);
         }
     }
 
     void decrementRefCount() {
-        if (!controlBlock) {
-            return;
-        }
-
-        int newRefCount;
-        {
-            LockGuard lock(controlBlock->mutex);
-            newRefCount = --controlBlock->referenceCount;
-        }
-
-        if (newRefCount == 0) {
-            delete object;
+        // Whoever removes the last reference must see everything done with
+        // the object through the others, hence acquire and release.
+        if (controlBlock &&
+            __atomic_sub_fetch(
+                &controlBlock->referenceCount, 1, __ATOMIC_ACQ_REL) == 0) {
             delete controlBlock;
         }
     }
@@ -71,7 +120,7 @@ class SharedPtr {
 
     explicit SharedPtr(OBJECT* object)
     : object(object)
-    , controlBlock(new SharedPtrControlBlock()) {
+    , controlBlock(new SharedPtrOwner<OBJECT>(object)) {
     }
 
     SharedPtr(const SharedPtr& other)
@@ -102,6 +151,13 @@ class SharedPtr {
         std::swap(left.controlBlock, right.controlBlock);
     }
 
+    // Release the currently managed object (if any), and then manage the
+    // specified `newObject` instead.
+    void reset(OBJECT* newObject) {
+        SharedPtr temporary(newObject);
+        swap(*this, temporary);
+    }
+
     OBJECT* get() const {
         return object;
     }
@@ -121,6 +177,19 @@ class SharedPtr {
     }
 };
 
+template <typename OBJECT>
+SharedPtr<OBJECT> makeShared() {
+    SharedPtrInPlace<OBJECT>* const block = new SharedPtrInPlace<OBJECT>();
+    return SharedPtr<OBJECT>(&block->object, block);
+}
+
+template <typename OBJECT, typename ARG>
+SharedPtr<OBJECT> makeShared(const ARG& arg) {
+    SharedPtrInPlace<OBJECT>* const block =
+        new SharedPtrInPlace<OBJECT>(arg);
+    return SharedPtr<OBJECT>(&block->object, block);
+}
+
 }  // namespace chan
 
 #endif  // #if __cplusplus >= 201103
@@ -51,12 +51,15 @@ inline DeadlineEvent deadline(TimePoint when) {
 inline DeadlineEvent deadline(std::chrono::steady_clock::time_point when) {
     typedef std::chrono::steady_clock steady_clock;
 
-    // We use millisecond precision here.  This is fine, since `::poll()` can
-    // do no better.
+    // `TimePoint` and `steady_clock` might not share an epoch, so convert
+    // via the duration from now.
     const steady_clock::duration duration = when - steady_clock::now();
-    const long durationMs = duration / std::chrono::milliseconds(1);
+    const std::chrono::seconds   whole =
+        std::chrono::duration_cast<std::chrono::seconds>(duration);
+    const std::chrono::nanoseconds fraction = duration - whole;
 
-    return DeadlineEvent(now() + milliseconds(durationMs));
+    return DeadlineEvent(now() + seconds(whole.count()) +
+                         nanoseconds(fraction.count()));
 }
 #endif
 
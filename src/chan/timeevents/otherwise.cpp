@@ -0,0 +1 @@
+#include <chan/timeevents/otherwise.h>
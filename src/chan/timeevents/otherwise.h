@@ -0,0 +1,55 @@
+#ifndef INCLUDED_CHAN_TIMEEVENTS_OTHERWISE
+#define INCLUDED_CHAN_TIMEEVENTS_OTHERWISE
+
+// This component provides `otherwise`, an event that `select` fulfills only if
+// none of the other events can be fulfilled without waiting.  It is the
+// analog of the `default` case of Go's `select` statement.  For example,
+//
+//     switch (chan::select(jobs.recv(&job), chan::otherwise())) {
+//         case 0:
+//             process(job);
+//             break;
+//         case 1:
+//             doSomethingElse();  // nobody was sending a job
+//     }
+//
+// never blocks.  A `select` involving only channel events and `otherwise`
+// does not make any system calls when it falls back to `otherwise`.  File
+// events are checked using a single non-blocking poll, and timeouts are
+// checked against the current time.
+
+#include <chan/errors/noexcept.h>
+#include <chan/event/ioevent.h>
+
+namespace chan {
+
+class EventContext;
+
+class OtherwiseEvent {
+  public:
+    void touch() CHAN_NOEXCEPT {
+    }
+
+    IoEvent file(const EventContext&) const {
+        IoEvent result;
+        result.otherwise = true;
+        return result;
+    }
+
+    IoEvent fulfill(IoEvent) const {
+        IoEvent result;
+        result.fulfilled = true;
+        return result;
+    }
+
+    void cancel(IoEvent) const {
+    }
+};
+
+inline OtherwiseEvent otherwise() {
+    return OtherwiseEvent();
+}
+
+}  // namespace chan
+
+#endif
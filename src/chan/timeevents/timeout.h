@@ -47,8 +47,15 @@ inline TimeoutEvent timeout(Duration duration) {
 }
 
 #if __cplusplus >= 201103
-inline TimeoutEvent timeout(std::chrono::milliseconds duration) {
-    return TimeoutEvent(milliseconds(duration / std::chrono::milliseconds(1)));
+// Any `std::chrono::duration` having a resolution of a nanosecond or coarser
+// (e.g. `std::chrono::microseconds(300)`) converts implicitly to the parameter
+// of this overload.
+inline TimeoutEvent timeout(std::chrono::nanoseconds duration) {
+    const std::chrono::seconds whole =
+        std::chrono::duration_cast<std::chrono::seconds>(duration);
+
+    return TimeoutEvent(seconds(whole.count()) +
+                        nanoseconds((duration - whole).count()));
 }
 #endif
 